@@ -16,10 +16,19 @@
 #include <avr/interrupt.h>
 #include "sch.h"
 #include "sch_cfg.h"
+#if SCH_STATIC_TABLE
+#include <avr/pgmspace.h>
+/* The schedule table stays in flash */
+#define SCH_TABLE_STORAGE PROGMEM
+#define SCH_TABLE_READ(Dest, Src) memcpy_P(&(Dest), &(Src), sizeof(Dest))
+#include "sch_table.h"
+#endif
 /**********************************************************************
 * Preprocessor Constants
 **********************************************************************/
 #define PRESCALER 64
+/* The ready mask bit of a task */
+#define READY_BIT(TaskId) ((ReadyMask_t)1 << (TaskId))
 /**********************************************************************
 * Typedefs
 **********************************************************************/
@@ -30,18 +39,50 @@
 typedef struct 
 {
   void (*Task)(void); /*< a pointer to the task function */
-  uint16_t Delay; /*< Delay in ticks until the function runs */
-  uint32_t Period; /*< Interval (ticks) between subsequent runs. */
-  uint16_t RunMe; /*< Incremented (by scheduler) when task is due to execute */
+  Sch_Tick_t Delay; /*< Delay in ticks until the function runs */
+  Sch_Tick_t Period; /*< Interval (ticks) between subsequent runs. */
+  Sch_Tick_t RunMe; /*< Incremented (by scheduler) when task is due to execute */
+  uint8_t Event; /*< Released by Sch_PostEvent only, never by the timer */
 } TaskConfig_t;
+
+/**
+* One bit per task, the narrowest type that fits SCH_MAX_TASKS.
+*/
+#if SCH_MAX_TASKS <= 8
+typedef uint8_t ReadyMask_t;
+#elif SCH_MAX_TASKS <= 16
+typedef uint16_t ReadyMask_t;
+#elif SCH_MAX_TASKS <= 32
+typedef uint32_t ReadyMask_t;
+#else
+typedef uint64_t ReadyMask_t;
+#endif
+
+#if SCH_STATIC_TABLE
+_Static_assert(SCH_TABLE_TASKS <= SCH_MAX_TASKS, "the schedule table has more tasks than SCH_MAX_TASKS");
+#endif
+/* SCH_NO_TASK must never be a valid task id */
+_Static_assert(SCH_MAX_TASKS < SCH_NO_TASK, "Sch_TaskId_t is too narrow for SCH_MAX_TASKS");
+_Static_assert(SCH_MAX_TASKS <= 64, "the ready mask holds up to 64 tasks");
 /**********************************************************************
 * Module Variable Definitions
 **********************************************************************/
 static TaskConfig_t Config[SCH_MAX_TASKS];
+/* Byte stores, so posting needs no critical section on any CPU */
+static volatile uint8_t Posted[SCH_MAX_TASKS]; /*< Set by Sch_PostEvent */
+static volatile uint8_t AnyPosted; /*< Set after any Posted entry */
+static volatile uint8_t TickPending; /*< Set by the timer interrupt */
+static ReadyMask_t Ready; /*< The bit of every task with RunMe > 0 */
+#if SCH_STATIC_TABLE
+static uint32_t TableIndex; /*< The schedule table entry of the next tick */
+#endif
 /**********************************************************************
 * Function Prototypes
 **********************************************************************/
 static void Sch_GoToSleep(void);
+static void Sch_Tick(void);
+static Sch_TaskId_t Sch_AddEntry(void (*Function)(void), const Sch_Tick_t Delay,
+                                 const Sch_Tick_t Period, const uint8_t Event);
 /**********************************************************************
 * Function Definitions
 **********************************************************************/
@@ -67,10 +108,12 @@ void
 Sch_Init(void)
 {
   //set the task parameters.
-  for (uint8_t TaskIndex = 0; TaskIndex < SCH_MAX_TASKS; TaskIndex++)
+  for (Sch_TaskId_t TaskIndex = 0; TaskIndex < SCH_MAX_TASKS; TaskIndex++)
     {
       Sch_DeleteTask(TaskIndex);
     }
+  AnyPosted = 0;
+  TickPending = 0;
 
   TCCR1A = 0;
   TCCR1B = 0;
@@ -100,15 +143,26 @@ Sch_Init(void)
 **********************************************************************/
 void Sch_DispatchTasks(void)
 {
-  uint8_t TaskId;
+  Sch_TaskId_t TaskId;
+  ReadyMask_t Mask;
 
-  // Dispatches (runs) the next task (if one is ready)
-  for (TaskId = 0; TaskId < SCH_MAX_TASKS; TaskId++)
+  // Dispatches (runs) the next task (if one is ready), the loop stops
+  // after the last one
+  for (TaskId = 0, Mask = Ready; Mask != 0; TaskId++, Mask >>= 1)
     {
-      if (Config[TaskId].Task != 0x0 && Config[TaskId].RunMe > 0)
+      if ((Mask & 1) && Config[TaskId].Task != 0x0 && Config[TaskId].RunMe > 0)
         {
           (*Config[TaskId].Task)(); // Run the task
           Config[TaskId].RunMe -= 1; // Reset / reduce RunMe flag
+          // A one-shot task runs once, then frees its slot
+          if (Config[TaskId].Period == 0 && !Config[TaskId].Event)
+            {
+              Sch_DeleteTask(TaskId);
+            }
+          else if (Config[TaskId].RunMe == 0)
+            {
+              Ready &= (ReadyMask_t)~READY_BIT(TaskId);
+            }
         }
     }
 }
@@ -136,7 +190,17 @@ void Sch_DispatchTasks(void)
 static void 
 Sch_GoToSleep(void)
 {
-  sleep_mode();
+  cli();
+  // A tick or a post that came during the dispatch is handled right away
+  if (!TickPending && !AnyPosted)
+    {
+      sleep_enable();
+      // sleep_cpu runs before any interrupt sei lets through
+      sei();
+      sleep_cpu();
+      sleep_disable();
+    }
+  sei();
 }
 
 /*********************************************************************
@@ -144,45 +208,184 @@ Sch_GoToSleep(void)
 *//**
 * \b Description:
 *
-* This function is used to add task to the scheduler. 
+* This function is used to add task to the scheduler. A one-shot task
+* (Period 0) runs once, Delay ticks from now, then its slot is freed and
+* its id may be handed out again. SCH_STATIC_TABLE has no one-shot tasks.
 *
 * PRE-CONDITION: Sch_Init() is called <br>
 * POST-CONDITION: The task will be added to the scheduler.
 *
 * @param Function a function pointer to the task function.
 * @param Delay a delay before the function executed for its first time
-* @param Period the period of the task
+* @param Period the period of the task, 0 for a one-shot task
 *
-* @return uint8_t the id of the task
+* @return Sch_TaskId_t the id of the task, or SCH_NO_TASK if the task
+* table is full.
 *
 * \b Example:
 * @code
 * Sch_Init();
 * // Make a task starting at 0 tick with period 10 ticks.
 * Sch_AddTask(count, 0, 10);
+* Sch_AddTask(retry, 50, 0); // Run retry once, 50 ticks from now.
 * @endcode
 *
 * @see Sch_Init
 *
 **********************************************************************/
-uint8_t 
+Sch_TaskId_t 
 Sch_AddTask(void (*Function)(),
-      const uint32_t Delay,
-      const uint32_t Period)
+      const Sch_Tick_t Delay,
+      const Sch_Tick_t Period)
 {
-  uint8_t TaskId = 0;
+  return Sch_AddEntry(Function, Delay, Period, 0);
+}
+
+/*********************************************************************
+* Function : Sch_AddEventTask()
+*//**
+* \b Description:
+*
+* This function is used to add a task that the timer never releases:
+* it runs in the Sch_Update that follows a Sch_PostEvent for it, instead
+* of polling its input from a periodic task. The task stays until it's
+* deleted.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The task will be added to the scheduler.
+*
+* @param Function a function pointer to the task function.
+*
+* @return Sch_TaskId_t the id of the task, or SCH_NO_TASK if the task
+* table is full (or, with SCH_STATIC_TABLE, the next free id is a table
+* one: add the event tasks after the table tasks).
+*
+* \b Example:
+* @code
+* Sch_Init();
+* RxTask = Sch_AddEventTask(handleRx);
+* @endcode
+*
+* @see Sch_PostEvent
+*
+**********************************************************************/
+Sch_TaskId_t 
+Sch_AddEventTask(void (*Function)(void))
+{
+  return Sch_AddEntry(Function, 0, 0, 1);
+}
+
+/*********************************************************************
+* Function : Sch_PostEvent()
+*//**
+* \b Description:
+*
+* This function is used to release a task once, from an interrupt
+* handler or from a task. It only stores bytes, so it needs neither a
+* lock nor a critical section. The task runs in the next Sch_Update,
+* which the interrupt wakes the CPU up for; the posts that come before
+* it are merged into one release. Any task can be posted, event tasks
+* are only released this way.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The task is released by the next Sch_Update.
+*
+* @param TaskId the id returned by Sch_AddEventTask or Sch_AddTask.
+*
+* @return int 0, or -1 for an invalid id.
+*
+* \b Example:
+* @code
+* ISR(USART_RXC_vect)
+* {
+*   Sch_PostEvent(RxTask);
+* }
+* @endcode
+*
+* @see Sch_AddEventTask
+*
+**********************************************************************/
+int 
+Sch_PostEvent(const Sch_TaskId_t TaskId)
+{
+  if (TaskId >= SCH_MAX_TASKS)
+    {
+      return -1;
+    }
+  Posted[TaskId] = 1;
+  // Set last: Sch_Update clears it before it looks at Posted
+  AnyPosted = 1;
+  return 0;
+}
+
+/*********************************************************************
+* Function : Sch_AddEntry()
+*//**
+* \b Description:
+* Utility function used to add a task in the first free slot.
+*
+* @param Function a function pointer to the task function.
+* @param Delay a delay before the function executed for its first time
+* @param Period the period of the task, 0 for a one-shot task
+* @param Event 1 for a task released by Sch_PostEvent only, Delay and
+* Period are then ignored.
+*
+* @return Sch_TaskId_t the id of the task, or SCH_NO_TASK.
+*
+* @see Sch_AddTask
+**********************************************************************/
+static Sch_TaskId_t 
+Sch_AddEntry(void (*Function)(void),
+      const Sch_Tick_t Delay,
+      const Sch_Tick_t Period,
+      const uint8_t Event)
+{
+  Sch_TaskId_t TaskId = 0;
 
   // First find a gap in the array (if there is one)
-  while ((Config[TaskId].Task != 0x0) && (TaskId < SCH_MAX_TASKS))
+  while ((TaskId < SCH_MAX_TASKS) && (Config[TaskId].Task != 0x0))
     {
       TaskId++;
     }
 
+  if (TaskId == SCH_MAX_TASKS)
+    {
+      // The task table is full
+      return SCH_NO_TASK;
+    }
+#if SCH_STATIC_TABLE
+  Sch_Tick_t TableDelay, TablePeriod;
+
+  // The event tasks go after the table ones, the table never lists them
+  if (Event)
+    {
+      if (TaskId < SCH_TABLE_TASKS)
+        {
+          return SCH_NO_TASK;
+        }
+    }
+  // The schedule table was generated for this id, delay and period
+  else if (TaskId >= SCH_TABLE_TASKS)
+    {
+      return SCH_NO_TASK;
+    }
+  else
+    {
+      SCH_TABLE_READ(TableDelay, SchTableDelay[TaskId]);
+      SCH_TABLE_READ(TablePeriod, SchTablePeriod[TaskId]);
+      if (Delay != TableDelay || Period != TablePeriod)
+        {
+          return SCH_NO_TASK;
+        }
+    }
+#endif
+
   // If we're here, there is a space in the task array
   Config[TaskId].Task = Function;
-  Config[TaskId].Delay = Delay;
-  Config[TaskId].Period = Period;
+  Config[TaskId].Delay = Event ? 0 : Delay;
+  Config[TaskId].Period = Event ? 0 : Period;
   Config[TaskId].RunMe = 0;
+  Config[TaskId].Event = Event;
 
   return TaskId;
 }
@@ -197,14 +400,14 @@ Sch_AddTask(void (*Function)(),
 * PRE-CONDITION: Sch_Init() is called <br>
 * POST-CONDITION: The task will be deleted.
 *
-* @param TaskId The id of the task to be deleted.
+* @param TaskId The id of the task to be deleted, SCH_NO_TASK is ignored.
 *
 * @return void
 *
 * \b Example:
 * @code
 * Sch_Init();
-* uint8_t taskId = Sch_AddTask(count, 0, 10); 
+* Sch_TaskId_t taskId = Sch_AddTask(count, 0, 10); 
 * Sch_DeleteTask(taskId);
 * @endcode
 *
@@ -213,12 +416,20 @@ Sch_AddTask(void (*Function)(),
 *
 **********************************************************************/
 void 
-Sch_DeleteTask(const uint8_t TaskId)
+Sch_DeleteTask(const Sch_TaskId_t TaskId)
 {
+  if (TaskId >= SCH_MAX_TASKS)
+    {
+      return;
+    }
   Config[TaskId].Task = 0x0;
   Config[TaskId].Delay = 0;
   Config[TaskId].Period = 0;
   Config[TaskId].RunMe = 0;
+  Config[TaskId].Event = 0;
+  // A post for the deleted task must not release the next one in the slot
+  Posted[TaskId] = 0;
+  Ready &= (ReadyMask_t)~READY_BIT(TaskId);
 }
 
 /*********************************************************************
@@ -226,7 +437,8 @@ Sch_DeleteTask(const uint8_t TaskId)
 *//**
 * \b Description:
 *
-* this function used to schedule the tasks at every tick. 
+* this function used to schedule the tasks at every tick, and to release
+* the posted tasks when an interrupt wakes the CPU up between two ticks.
 *
 * PRE-CONDITION: Sch_Init() is called <br>
 * POST-CONDITION: The tasks are scheduled according to their configuration.
@@ -244,18 +456,108 @@ Sch_DeleteTask(const uint8_t TaskId)
 void 
 Sch_Update(void)
 {
-  uint8_t Index;
+  Sch_TaskId_t Index;
+
+  // An interrupt other than the timer one may have woken the CPU up
+  if (TickPending)
+    {
+      TickPending = 0;
+      Sch_Tick();
+    }
+
+  // A post that comes after its entry is checked is taken next time
+  if (AnyPosted)
+    {
+      AnyPosted = 0;
+      for (Index = 0; Index < SCH_MAX_TASKS; Index++)
+        {
+          if (Posted[Index])
+            {
+              Posted[Index] = 0;
+              if (Config[Index].Task != 0x0)
+                {
+                  Config[Index].RunMe += 1;
+                  Ready |= READY_BIT(Index);
+                }
+            }
+        }
+    }
+
+  Sch_DispatchTasks();
+
+  // The scheduler enters idle mode at this point
+  Sch_GoToSleep();
+}
+
+/*********************************************************************
+* Function : Sch_Tick()
+*//**
+* \b Description:
+* Utility function used to release the tasks due at one timer tick.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The due tasks have their RunMe incremented.
+*
+* @return void
+*
+* @see Sch_Update
+**********************************************************************/
+static void 
+Sch_Tick(void)
+{
+#if SCH_STATIC_TABLE
+  Sch_TaskId_t TaskId;
+#ifdef SCH_TABLE_LIST
+  uint32_t Entry, End;
+
+  // The tasks due this tick were listed offline
+  SCH_TABLE_READ(Entry, SchTableStart[TableIndex]);
+  SCH_TABLE_READ(End, SchTableStart[TableIndex + 1]);
+  for (; Entry < End; Entry++)
+    {
+      SCH_TABLE_READ(TaskId, SchTableIds[Entry]);
+#else
+  SCH_TABLE_MASK_TYPE Mask;
+
+  // The tasks due this tick were computed offline
+  SCH_TABLE_READ(Mask, SchTable[TableIndex]);
+  for (TaskId = 0; Mask != 0; TaskId++, Mask >>= 1)
+    {
+      if (!(Mask & 1))
+        {
+          continue;
+        }
+#endif
+      // A deleted task keeps its bits in the table
+      if (Config[TaskId].Task != 0x0)
+        {
+          Config[TaskId].RunMe += 1;
+          Ready |= READY_BIT(TaskId);
+        }
+    }
+  if (++TableIndex == SCH_TABLE_LENGTH)
+    {
+      TableIndex = 0;
+    }
+#else
+  Sch_TaskId_t Index;
+
   for (Index = 0; Index < SCH_MAX_TASKS; Index++)
     {
-      // Check if there is a task at this location
-      if (Config[Index].Task != 0x0)
+      // Check if there is a task released by the timer at this location
+      if (Config[Index].Task != 0x0 && !Config[Index].Event)
         {
           if (Config[Index].Delay == 0)
             {
               // The task is due to run
-              Config[Index].RunMe += 1; 
-              // Schedule periodic tasks to run again
-              Config[Index].Delay = Config[Index].Period - 1;
+              Config[Index].RunMe += 1;
+              Ready |= READY_BIT(Index);
+              // Schedule periodic tasks to run again, a one-shot task is
+              // deleted once it has run
+              if (Config[Index].Period != 0)
+                {
+                  Config[Index].Delay = Config[Index].Period - 1;
+                }
             }
           else
             {
@@ -264,11 +566,7 @@ Sch_Update(void)
             }
         }
     }
-  
-  Sch_DispatchTasks();
-
-  // The scheduler enters idle mode at this point
-  Sch_GoToSleep();
+#endif
 }
 
 /*********************************************************************
@@ -296,6 +594,8 @@ Sch_Update(void)
 void 
 Sch_Start(void)
 { 
+  //The first Sch_Update processes tick 0 right away
+  TickPending = 1;
   //Start the timer
   TCCR1B |= 1 << CS11 | 1 << CS10;
   //enable the global interrupt mask
@@ -319,7 +619,8 @@ Sch_Start(void)
 static void inline
 TimerHandler(void)
 {
-  //Do nothing, just wake up the CPU
+  //Wake up the CPU for a tick
+  TickPending = 1;
 
   //clear the timer interrupt flag
   TIFR |= 1 << OCF1A;
@@ -17,5 +17,16 @@
 /*< The maximum number of tasks in the project */
 #define SCH_MAX_TASKS (1)
 
+/*< The type of task ids, it must hold SCH_MAX_TASKS + 1 values */
+#define SCH_TASK_ID_TYPE uint8_t
+
+/*< The type of tick counts (delays, periods and pending runs) */
+#define SCH_TICK_TYPE uint32_t
+
+/*< 1: Sch_Update reads the tasks due every tick from the static schedule
+ *  table sch_table.h, generated offline by tools/sch_table_gen, instead
+ *  of counting down the delay of every task */
+#define SCH_STATIC_TABLE 0
+
 #endif /* end SCH_CFG_H */
 /************************* END OF FILE ********************************/
@@ -0,0 +1,115 @@
+/**
+ * @file dispatch_bench.cpp
+ * @author Mohamed Hassanin
+ * @brief Compares one tick plus dispatch of the C scheduler
+ *  (Sch_Tick + Sch_DispatchTasks) with the same task set declared as a
+ *  compile-time Sch::Table (Update + Dispatch).
+ *  There are SCH_MAX_TASKS tasks of period 4 with staggered delays, each
+ *  one incrementing its own counter, so a quarter of them run per tick.
+ *  The output is one CSV line per front end:
+ *  front,tasks,ticks,ns_per_tick,runs
+ * @version 0.1
+ * @date 2021-02-14
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "sch.hpp"
+
+#define DEFAULT_TICKS 200000ul
+#define PERIOD 4u
+
+static unsigned long Counters[SCH_MAX_TASKS];
+
+template <size_t Index>
+static void Job(void)
+{
+  Counters[Index]++;
+}
+
+template <typename Sequence>
+struct MakeTable;
+
+template <size_t... Indices>
+struct MakeTable<std::index_sequence<Indices...>>
+{
+  using Type = Sch::Table<Sch::Task<Job<Indices>, PERIOD, Indices % PERIOD>...>;
+  static constexpr void (*Jobs[])(void) = { Job<Indices>... };
+};
+
+using Tasks = MakeTable<std::make_index_sequence<SCH_MAX_TASKS>>;
+
+static double ElapsedNs(const struct timespec *Start, const struct timespec *End);
+static unsigned long TakeRuns(void);
+
+int main(int argc, char *argv[])
+{
+  unsigned long Ticks = DEFAULT_TICKS;
+  unsigned long Tick;
+  uint32_t Index;
+  struct timespec Start, End;
+  double Ns;
+
+  if (argc > 1)
+    {
+      Ticks = strtoul(argv[1], NULL, 0);
+    }
+
+  Sch_Init();
+  for (Index = 0; Index < SCH_MAX_TASKS; Index++)
+    {
+      Sch_AddTask(Tasks::Jobs[Index], Index % PERIOD, PERIOD);
+    }
+  clock_gettime(CLOCK_MONOTONIC, &Start);
+  for (Tick = 0; Tick < Ticks; Tick++)
+    {
+      Sch_Tick();
+      Sch_DispatchTasks();
+    }
+  clock_gettime(CLOCK_MONOTONIC, &End);
+  Ns = ElapsedNs(&Start, &End);
+  printf("c,%u,%lu,%.1f,%lu\n", (unsigned)SCH_MAX_TASKS, Ticks, Ns / Ticks, TakeRuns());
+  Sch_Deinit();
+
+  clock_gettime(CLOCK_MONOTONIC, &Start);
+  for (Tick = 0; Tick < Ticks; Tick++)
+    {
+      Tasks::Type::Update();
+      Tasks::Type::Dispatch();
+    }
+  clock_gettime(CLOCK_MONOTONIC, &End);
+  Ns = ElapsedNs(&Start, &End);
+  printf("cpp,%u,%lu,%.1f,%lu\n", (unsigned)SCH_MAX_TASKS, Ticks, Ns / Ticks, TakeRuns());
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief The time between two CLOCK_MONOTONIC readings in ns.
+ *
+ */
+static double ElapsedNs(const struct timespec *Start, const struct timespec *End)
+{
+  return (End->tv_sec - Start->tv_sec) * 1e9 + (End->tv_nsec - Start->tv_nsec);
+}
+
+/**
+ * @brief Sums and clears the task counters, so both front ends are
+ *  checked to run the same number of tasks.
+ *
+ */
+static unsigned long TakeRuns(void)
+{
+  unsigned long Runs = 0;
+  uint32_t Index;
+
+  for (Index = 0; Index < SCH_MAX_TASKS; Index++)
+    {
+      Runs += Counters[Index];
+      Counters[Index] = 0;
+    }
+  return Runs;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file idle_bench.c
+ * @author Mohamed Hassanin
+ * @brief Runs the task set of main.c for a few seconds and reports how
+ *  many times the scheduler woke up compared to the ticks it processed.
+ *  The output is one CSV line: 
+ *  mode,seconds,ticks,wakeups,wakeups_per_sec,saved_per_sec
+ * @version 0.1
+ * @date 2021-02-14
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "sch.h"
+#include "sch_cfg.h"
+
+#define DEFAULT_SECONDS 3.0
+
+static void Task1(void);
+static void Task2(void);
+static double Now(void);
+
+int main(int argc, char *argv[])
+{
+  double Seconds = DEFAULT_SECONDS;
+  double Start;
+  Sch_IdleStats_t Stats;
+
+  if (argc > 1)
+    {
+      Seconds = strtod(argv[1], NULL);
+    }
+
+  Sch_Init();
+  Sch_AddTask(Task1, 0, 100);
+  Sch_AddTask(Task2, 1, 50);
+  Sch_Start();
+
+  Start = Now();
+  while (Now() - Start < Seconds)
+    {
+      Sch_Update();
+    }
+
+  Sch_GetIdleStats(&Stats);
+  printf("%s,%.1f,%u,%u,%.1f,%.1f\n",
+         SCH_TICKLESS ? "tickless" : "periodic", Seconds,
+         Stats.Ticks, Stats.Wakeups, Stats.Wakeups / Seconds,
+         1000.0 / TICK - Stats.Wakeups / Seconds);
+
+  Sch_Deinit();
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Utility function: the monotonic time in seconds.
+ *
+ */
+static double Now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief A task function for Task1
+ *
+ */
+static void Task1(void)
+{
+}
+
+/**
+ * @brief A task function for Task2
+ *
+ */
+static void Task2(void)
+{
+}
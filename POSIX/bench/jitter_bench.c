@@ -0,0 +1,324 @@
+/**
+ * @file jitter_bench.c
+ * @author Mohamed Hassanin
+ * @brief Runs a configurable task set on the real timer for a fixed
+ *  duration and reports the tick jitter percentiles, the drift of every
+ *  task release from its ideal time, the missed and merged ticks and the
+ *  CPU usage, for the backend and mode the scheduler is compiled with.
+ *
+ *  Usage: jitter_bench [-n tasks] [-p periods] [-w work_us] [-d seconds]
+ *                      [-f csv|json] [-H]
+ *    -n  number of tasks (1..JITTER_MAX_TASKS, default 4)
+ *    -p  comma separated periods in ticks, cycled over the tasks
+ *        (default 1,2,5,10), task i is delayed by i % its period
+ *    -w  busy work of every task run in us (default 0)
+ *    -d  duration in seconds (default 5)
+ *    -f  output format (default csv)
+ *    -H  print the CSV header line first
+ *
+ *  The tick jitter is measured by a probe task of period 1 dispatched
+ *  first: the difference between two consecutive probe runs and a tick.
+ * @version 0.1
+ * @date 2021-02-14
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "sch.h"
+#include "sch_cfg.h"
+
+#define JITTER_MAX_TASKS 16u
+#define NS_PER_TICK ((int64_t)TICK * 1000000)
+#define CSV_HEADER "backend,mode,tasks,work_us,seconds,ticks,expected_ticks," \
+  "missed_ticks,merged_ticks,jitter_p50_us,jitter_p90_us,jitter_p99_us," \
+  "jitter_p999_us,jitter_max_us,drift_mean_us,drift_max_us,missed_releases," \
+  "cpu_pct"
+
+_Static_assert(SCH_MAX_TASKS > JITTER_MAX_TASKS, "build with SCH_MAX_TASKS > JITTER_MAX_TASKS");
+
+/**
+ * @brief The release accounting of one benchmark task.
+ *
+ */
+typedef struct
+{
+  Sch_Tick_t Delay; /*< The delay it was added with */
+  Sch_Tick_t Period; /*< The period it was added with */
+  uint64_t Runs; /*< Times it ran */
+  int64_t DriftSum; /*< Sum of (actual - ideal) release times, in ns */
+  int64_t DriftMax; /*< Largest |actual - ideal|, in ns */
+  int64_t DriftLast; /*< Drift of the last release, in ns */
+} JitterTask_t;
+
+static JitterTask_t Tasks[JITTER_MAX_TASKS];
+static int64_t Start; /*< Time of tick 0 */
+static uint32_t WorkUs;
+static int64_t *Samples; /*< |probe interval - tick| of every tick, in ns */
+static size_t SampleCount;
+static size_t SampleCapacity;
+static int64_t ProbeLast;
+
+static int64_t NowNs(void);
+static void Release(const uint32_t Index);
+static void Probe(void);
+static int CompareNs(const void *A, const void *B);
+static double Percentile(const double Fraction);
+
+#define JITTER_TASK(n) static void Task##n(void) { Release(n); }
+JITTER_TASK(0) JITTER_TASK(1) JITTER_TASK(2) JITTER_TASK(3)
+JITTER_TASK(4) JITTER_TASK(5) JITTER_TASK(6) JITTER_TASK(7)
+JITTER_TASK(8) JITTER_TASK(9) JITTER_TASK(10) JITTER_TASK(11)
+JITTER_TASK(12) JITTER_TASK(13) JITTER_TASK(14) JITTER_TASK(15)
+
+static void (*const TaskFunctions[JITTER_MAX_TASKS])(void) =
+{
+  Task0, Task1, Task2, Task3, Task4, Task5, Task6, Task7,
+  Task8, Task9, Task10, Task11, Task12, Task13, Task14, Task15
+};
+
+int main(int argc, char *argv[])
+{
+  uint32_t TaskCount = 4;
+  const char *PeriodList = "1,2,5,10";
+  double Seconds = 5.0;
+  const char *Format = "csv";
+  int Header = 0;
+  Sch_Tick_t Periods[JITTER_MAX_TASKS];
+  uint32_t PeriodCount = 0;
+  char *List, *Item;
+  uint32_t Index;
+  int Option;
+  int64_t Elapsed;
+  uint64_t ExpectedTicks, Expected, MissedReleases = 0, Runs = 0;
+  int64_t DriftSum = 0, DriftMax = 0;
+  Sch_IdleStats_t Idle;
+  struct rusage Usage;
+  double CpuSeconds;
+
+  while ((Option = getopt(argc, argv, "n:p:w:d:f:H")) != -1)
+    {
+      switch (Option)
+        {
+        case 'n': TaskCount = strtoul(optarg, NULL, 0); break;
+        case 'p': PeriodList = optarg; break;
+        case 'w': WorkUs = strtoul(optarg, NULL, 0); break;
+        case 'd': Seconds = strtod(optarg, NULL); break;
+        case 'f': Format = optarg; break;
+        case 'H': Header = 1; break;
+        default:
+          fprintf(stderr, "usage: %s [-n tasks] [-p periods] [-w work_us] "
+                  "[-d seconds] [-f csv|json] [-H]\n", argv[0]);
+          return EXIT_FAILURE;
+        }
+    }
+  if (TaskCount == 0 || TaskCount > JITTER_MAX_TASKS)
+    {
+      fprintf(stderr, "tasks must be in 1..%u\n", JITTER_MAX_TASKS);
+      return EXIT_FAILURE;
+    }
+
+  List = strdup(PeriodList);
+  for (Item = strtok(List, ","); Item != NULL && PeriodCount < JITTER_MAX_TASKS;
+       Item = strtok(NULL, ","))
+    {
+      Periods[PeriodCount] = strtoul(Item, NULL, 0);
+      if (Periods[PeriodCount] == 0)
+        {
+          fprintf(stderr, "periods must be > 0\n");
+          return EXIT_FAILURE;
+        }
+      PeriodCount++;
+    }
+  free(List);
+  if (PeriodCount == 0)
+    {
+      fprintf(stderr, "no period given\n");
+      return EXIT_FAILURE;
+    }
+
+  SampleCapacity = (size_t)(Seconds * 1000 / TICK) + 16;
+  Samples = malloc(SampleCapacity * sizeof(*Samples));
+  if (Samples == NULL)
+    {
+      perror("malloc");
+      return EXIT_FAILURE;
+    }
+
+  Sch_Init();
+  // The probe is added first so it runs first in every tick
+  Sch_AddTask(Probe, 0, 1);
+  for (Index = 0; Index < TaskCount; Index++)
+    {
+      Tasks[Index].Period = Periods[Index % PeriodCount];
+      Tasks[Index].Delay = Index % Tasks[Index].Period;
+      Sch_AddTask(TaskFunctions[Index], Tasks[Index].Delay, Tasks[Index].Period);
+    }
+
+  Start = NowNs();
+  Sch_Start();
+  do
+    {
+      Sch_Update();
+      Elapsed = NowNs() - Start;
+    }
+  while (Elapsed < Seconds * 1e9);
+
+  Sch_GetIdleStats(&Idle);
+  getrusage(RUSAGE_SELF, &Usage);
+  Sch_Deinit();
+
+  /* Sch_Update returns on the wakeup of a tick it hasn't processed yet,
+  so ticks 0 .. ExpectedTicks - 1 should have been processed */
+  ExpectedTicks = Elapsed / NS_PER_TICK;
+  for (Index = 0; Index < TaskCount; Index++)
+    {
+      Expected = 0;
+      if (ExpectedTicks > Tasks[Index].Delay)
+        {
+          Expected = 1 + (ExpectedTicks - 1 - Tasks[Index].Delay) / Tasks[Index].Period;
+        }
+      if (Expected > Tasks[Index].Runs)
+        {
+          MissedReleases += Expected - Tasks[Index].Runs;
+        }
+      Runs += Tasks[Index].Runs;
+      DriftSum += Tasks[Index].DriftSum;
+      if (Tasks[Index].DriftMax > DriftMax)
+        {
+          DriftMax = Tasks[Index].DriftMax;
+        }
+    }
+  CpuSeconds = Usage.ru_utime.tv_sec + Usage.ru_utime.tv_usec / 1e6 +
+    Usage.ru_stime.tv_sec + Usage.ru_stime.tv_usec / 1e6;
+  qsort(Samples, SampleCount, sizeof(*Samples), CompareNs);
+
+#define JITTER_FIELDS \
+  SCH_BACKEND == SCH_BACKEND_TIMERFD ? "timerfd" : "signal", \
+  SCH_TICKLESS ? "tickless" : "periodic", TaskCount, WorkUs, Elapsed / 1e9, \
+  Idle.Ticks, (unsigned long long)ExpectedTicks, \
+  (unsigned long long)(ExpectedTicks > Idle.Ticks ? ExpectedTicks - Idle.Ticks : 0), \
+  Idle.Ticks > Idle.Wakeups ? Idle.Ticks - Idle.Wakeups : 0, \
+  Percentile(0.5), Percentile(0.9), Percentile(0.99), Percentile(0.999), \
+  Percentile(1.0), Runs ? DriftSum / 1e3 / Runs : 0.0, DriftMax / 1e3, \
+  (unsigned long long)MissedReleases, 100.0 * CpuSeconds / (Elapsed / 1e9)
+
+  if (strcmp(Format, "json") == 0)
+    {
+      printf("{\"backend\":\"%s\",\"mode\":\"%s\",\"tasks\":%u,\"work_us\":%u,"
+             "\"seconds\":%.3f,\"ticks\":%u,\"expected_ticks\":%llu,"
+             "\"missed_ticks\":%llu,\"merged_ticks\":%u,"
+             "\"jitter_us\":{\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,"
+             "\"p999\":%.1f,\"max\":%.1f},\"drift_mean_us\":%.1f,"
+             "\"drift_max_us\":%.1f,\"missed_releases\":%llu,\"cpu_pct\":%.2f,"
+             "\"per_task\":[", JITTER_FIELDS);
+      for (Index = 0; Index < TaskCount; Index++)
+        {
+          printf("%s{\"period\":%u,\"delay\":%u,\"runs\":%llu,"
+                 "\"drift_mean_us\":%.1f,\"drift_max_us\":%.1f,"
+                 "\"drift_last_us\":%.1f}", Index ? "," : "",
+                 (unsigned)Tasks[Index].Period, (unsigned)Tasks[Index].Delay,
+                 (unsigned long long)Tasks[Index].Runs,
+                 Tasks[Index].Runs ? Tasks[Index].DriftSum / 1e3 / Tasks[Index].Runs : 0.0,
+                 Tasks[Index].DriftMax / 1e3, Tasks[Index].DriftLast / 1e3);
+        }
+      printf("]}\n");
+    }
+  else
+    {
+      if (Header)
+        {
+          printf("%s\n", CSV_HEADER);
+        }
+      printf("%s,%s,%u,%u,%.3f,%u,%llu,%llu,%u,%.1f,%.1f,%.1f,%.1f,%.1f,"
+             "%.1f,%.1f,%llu,%.2f\n", JITTER_FIELDS);
+    }
+
+  free(Samples);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Utility function: the monotonic time in nanoseconds.
+ *
+ */
+static int64_t NowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief Accounts one release of a benchmark task against its ideal
+ *  time, then burns its synthetic work.
+ *
+ * @param Index the benchmark task.
+ */
+static void Release(const uint32_t Index)
+{
+  JitterTask_t *Task = &Tasks[Index];
+  int64_t Now = NowNs();
+  int64_t Ideal = Start +
+    (int64_t)(Task->Delay + Task->Runs * Task->Period) * NS_PER_TICK;
+  int64_t Drift = Now - Ideal;
+
+  Task->Runs++;
+  Task->DriftSum += Drift;
+  Task->DriftLast = Drift;
+  if (llabs(Drift) > Task->DriftMax)
+    {
+      Task->DriftMax = llabs(Drift);
+    }
+
+  while (NowNs() - Now < (int64_t)WorkUs * 1000)
+    {
+    }
+}
+
+/**
+ * @brief The period 1 task sampling the tick interval.
+ *
+ */
+static void Probe(void)
+{
+  int64_t Now = NowNs();
+
+  if (ProbeLast != 0 && SampleCount < SampleCapacity)
+    {
+      Samples[SampleCount++] = llabs(Now - ProbeLast - NS_PER_TICK);
+    }
+  ProbeLast = Now;
+}
+
+/**
+ * @brief qsort comparator of nanosecond samples.
+ *
+ */
+static int CompareNs(const void *A, const void *B)
+{
+  int64_t Left = *(const int64_t *)A;
+  int64_t Right = *(const int64_t *)B;
+
+  return (Left > Right) - (Left < Right);
+}
+
+/**
+ * @brief The given percentile of the sorted jitter samples, in us.
+ *
+ * @param Fraction 0.5 for the median, 1.0 for the maximum.
+ */
+static double Percentile(const double Fraction)
+{
+  if (SampleCount == 0)
+    {
+      return 0.0;
+    }
+  return Samples[(size_t)(Fraction * (SampleCount - 1))] / 1e3;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file sim_bench.c
+ * @author Mohamed Hassanin
+ * @brief Capacity planning of a task set on the simulated-time backend
+ *  (SCH_BACKEND_SIM): the tasks of a task file run for a span of
+ *  simulated time, each run costing its declared WCET, then the
+ *  utilization report of Sch_SimReport is printed. A day of 10 ms ticks
+ *  takes seconds.
+ *
+ *  Usage: sim_bench [-s seconds] [-o trace.bin] tasks.tbl
+ *    -s  the simulated time, a day (86400 s) by default
+ *    -o  also record the whole schedule (Sch_SimTrace), for
+ *        tools/sch_trace2json
+ *
+ *  The task file is the one of tools/sch_table_gen:
+ *    <name> <delay> <period> [wcet_us]
+ *  A task without a WCET is charged the host time of an empty call.
+ * @version 0.1
+ * @date 2021-03-04
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include "sch.h"
+#include "sch_cfg.h"
+
+#define DEFAULT_SECONDS 86400.0
+
+static int AddTasks(const char *Path);
+static void SimTask(void);
+
+int main(int argc, char *argv[])
+{
+  double Seconds = DEFAULT_SECONDS;
+  const char *TracePath = NULL;
+  int Option;
+
+  while ((Option = getopt(argc, argv, "s:o:")) != -1)
+    {
+      switch (Option)
+        {
+        case 's': Seconds = strtod(optarg, NULL); break;
+        case 'o': TracePath = optarg; break;
+        default:
+          fprintf(stderr, "usage: %s [-s seconds] [-o trace.bin] tasks.tbl\n", argv[0]);
+          return EXIT_FAILURE;
+        }
+    }
+  if (optind != argc - 1 || Seconds <= 0.0 || Seconds * 1000.0 / TICK > UINT32_MAX)
+    {
+      fprintf(stderr, "usage: %s [-s seconds] [-o trace.bin] tasks.tbl\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  Sch_Init();
+  if (AddTasks(argv[optind]) != 0)
+    {
+      return EXIT_FAILURE;
+    }
+  if (TracePath != NULL && Sch_SimTrace(TracePath) != 0)
+    {
+      perror(TracePath);
+      return EXIT_FAILURE;
+    }
+  if (Sch_SimRun((uint32_t)(Seconds * 1000.0 / TICK)) != 0)
+    {
+      perror("Sch_SimRun");
+      return EXIT_FAILURE;
+    }
+  Sch_SimReport(stdout);
+  Sch_Deinit();
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Add the tasks of the task file, in its line order, with their
+ *  WCET.
+ *
+ * @return int 0 on success, -1 otherwise.
+ */
+static int AddTasks(const char *Path)
+{
+  FILE *In = fopen(Path, "r");
+  char Line[256], Name[64];
+  uint32_t LineNumber = 0, Delay, Period, WcetUs;
+  Sch_TaskId_t TaskId;
+  int Fields;
+
+  if (In == NULL)
+    {
+      perror(Path);
+      return -1;
+    }
+  while (fgets(Line, sizeof(Line), In) != NULL)
+    {
+      LineNumber++;
+      Line[strcspn(Line, "#\n")] = '\0';
+      if (strspn(Line, " \t\r") == strlen(Line))
+        {
+          continue;
+        }
+      WcetUs = 0;
+      Fields = sscanf(Line, "%63s %" SCNu32 " %" SCNu32 " %" SCNu32,
+                      Name, &Delay, &Period, &WcetUs);
+      if (Fields < 3 || Period == 0)
+        {
+          fprintf(stderr, "%s:%u: expected <name> <delay> <period> [wcet_us]\n",
+                  Path, LineNumber);
+          fclose(In);
+          return -1;
+        }
+      TaskId = Sch_AddTask(SimTask, Delay, Period);
+      if (TaskId == SCH_NO_TASK)
+        {
+          fprintf(stderr, "%s:%u: more than SCH_MAX_TASKS tasks\n", Path, LineNumber);
+          fclose(In);
+          return -1;
+        }
+      Sch_SetTaskWcet(TaskId, WcetUs);
+    }
+  fclose(In);
+  return 0;
+}
+
+/**
+ * @brief The body of every task, its cost is the declared one.
+ *
+ */
+static void SimTask(void)
+{
+}
@@ -0,0 +1,70 @@
+/**
+ * @file tick_bench.c
+ * @author Mohamed Hassanin
+ * @brief Measures the cost of one scheduler tick (Sch_Tick) for the
+ *  engine and table size the scheduler is compiled with.
+ *  Every task has a period of 4 ticks per task with staggered delays,
+ *  so a quarter of a task is due per tick whatever the table size is.
+ *  The output is one CSV line: engine,tasks,ticks,ns_per_tick,releases
+ * @version 0.1
+ * @date 2021-02-14
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "sch.h"
+#include "sch_cfg.h"
+
+#define DEFAULT_TICKS 200000ul
+#define TICKS_PER_TASK 4u
+
+static void Job(void);
+
+int main(int argc, char *argv[])
+{
+  unsigned long Ticks = DEFAULT_TICKS;
+  unsigned long Tick;
+  uint32_t TaskIndex;
+  struct timespec Start, End;
+  double Ns;
+
+  if (argc > 1)
+    {
+      Ticks = strtoul(argv[1], NULL, 0);
+    }
+
+  Sch_Init();
+  for (TaskIndex = 0; TaskIndex < SCH_MAX_TASKS; TaskIndex++)
+    {
+      Sch_AddTask(Job, TaskIndex * TICKS_PER_TASK,
+                  SCH_MAX_TASKS * TICKS_PER_TASK);
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &Start);
+  for (Tick = 0; Tick < Ticks; Tick++)
+    {
+      Sch_Tick();
+    }
+  clock_gettime(CLOCK_MONOTONIC, &End);
+
+  Ns = (End.tv_sec - Start.tv_sec) * 1e9 + (End.tv_nsec - Start.tv_nsec);
+  printf("%s,%u,%lu,%.1f,%lu\n",
+         SCH_ENGINE == SCH_ENGINE_WHEEL ? "wheel" :
+         SCH_LAYOUT == SCH_LAYOUT_SOA ? "linear_soa" : "linear",
+         (unsigned)SCH_MAX_TASKS, Ticks, Ns / Ticks,
+         Ticks / TICKS_PER_TASK);
+
+  Sch_Deinit();
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief An empty task, the benchmark never dispatches it.
+ *
+ */
+static void Job(void)
+{
+}
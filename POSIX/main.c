@@ -48,8 +48,13 @@ int main(void)
 
   Sch_Init();
 
-  uint8_t task1Id = Sch_AddTask(count1, 0, 100);
-  uint8_t task2Id = Sch_AddTask(count2, 1, 50);
+  Sch_TaskId_t task1Id = Sch_AddTask(count1, 0, 100);
+  Sch_TaskId_t task2Id = Sch_AddTask(count2, 1, 50);
+  if (task1Id == SCH_NO_TASK || task2Id == SCH_NO_TASK)
+    {
+      fprintf(stderr, "Sch_AddTask: the task table is full\n");
+      exit(EXIT_FAILURE);
+    }
   
   Sch_Start();
   
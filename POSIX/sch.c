@@ -12,7 +12,58 @@
 /**********************************************************************
 * Module Preprocessor Constants
 **********************************************************************/
+#define _GNU_SOURCE /* CPU affinity and thread directed timer signals */
 #define CLOCKID CLOCK_MONOTONIC
+
+/* Timing wheel geometry: a 256 slots root level followed by four 64 slots
+ * levels, which covers the whole 32-bit tick range. */
+#define WHEEL_ROOT_BITS 8
+#define WHEEL_LVL_BITS 6
+#define WHEEL_LEVELS 4
+#define WHEEL_ROOT_SIZE (1u << WHEEL_ROOT_BITS)
+#define WHEEL_LVL_SIZE (1u << WHEEL_LVL_BITS)
+#define WHEEL_ROOT_MASK (WHEEL_ROOT_SIZE - 1)
+#define WHEEL_LVL_MASK (WHEEL_LVL_SIZE - 1)
+#define WHEEL_SLOTS (WHEEL_ROOT_SIZE + WHEEL_LEVELS * WHEEL_LVL_SIZE)
+/* The slot index inside Level (1..WHEEL_LEVELS) that a tick maps to */
+#define WHEEL_INDEX(Tick, Level) \
+  (((Tick) >> (WHEEL_ROOT_BITS + ((Level) - 1) * WHEEL_LVL_BITS)) & WHEEL_LVL_MASK)
+/* Marks the end of a wheel slot list */
+#define WHEEL_NIL SCH_NO_TASK
+
+#define DEQUE_MASK (SCH_DEQUE_SIZE - 1)
+#define CMD_MASK (SCH_CMD_QUEUE_SIZE - 1)
+#define TRACE_MASK ((uint64_t)SCH_TRACE_SIZE - 1)
+
+/* The clock is virtual, advanced by the sleeps and the task runs */
+#define SCH_SIM (SCH_BACKEND == SCH_BACKEND_SIM)
+/* Ticks are read from the clock instead of counted from timer wakeups */
+#define SCH_CLOCK_DRIVEN (SCH_TICKLESS || SCH_ABSTIME || SCH_SIM)
+/* The virtual time of Sch_Init, not 0 which means "not started" */
+#define SIM_EPOCH_NS ((uint64_t)NS_PER_SEC)
+
+/* epoll keys of the timerfd backend, application fds follow FD_KEY_APP */
+#define FD_KEY_TIMER 0u
+#define FD_KEY_WAKE 1u
+#define FD_KEY_APP 2u
+
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+/* A stolen task may run on several workers at once */
+#define STATS_ADD(Field, Value) __atomic_fetch_add(&(Field), (Value), __ATOMIC_RELAXED)
+#else
+#define STATS_ADD(Field, Value) ((Field) += (Value))
+#endif
+
+#define NS_PER_TICK ((uint64_t)TICK * 1000000u)
+#define NS_PER_SEC 1000000000u
+
+#if SCH_TRACE
+/* Records an event of the instance Sch, its own task unless told otherwise */
+#define TRACE(Sch, Type, Id, Arg) \
+  Trace_Record((Sch), (Type), (Id), (Arg), (uint8_t)((Sch) - Instances), Trace_Now())
+#else
+#define TRACE(Sch, Type, Id, Arg) ((void)0)
+#endif
 /**********************************************************************
 * Includes
 **********************************************************************/
@@ -22,11 +73,95 @@
 #include <signal.h>
 #include <time.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <string.h>
+#include <errno.h>
 #include "sch.h"
 #include "sch_cfg.h"
+#if SCH_ENGINE == SCH_ENGINE_TABLE
+#include "sch_table.h"
+#endif
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
+#include <sys/timerfd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+#if SCH_SHM
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "sch_shm.h"
+#endif
+#if SCH_TRACE
+#include "sch_trace.h"
+#endif
+#if SCH_SHM || SCH_TRACE
+#include <limits.h>
+#endif
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+/* The words of the live task bitmap, each covers 64 task ids */
+#define LIVE_WORDS ((SCH_MAX_TASKS + 63u) / 64u)
+/* Set and clear the bit of a task id in a LIVE_WORDS bitmap */
+#define BIT_SET(Map, TaskId) ((Map)[(TaskId) / 64u] |= (uint64_t)1 << ((TaskId) % 64u))
+#define BIT_CLEAR(Map, TaskId) ((Map)[(TaskId) / 64u] &= ~((uint64_t)1 << ((TaskId) % 64u)))
+#define BIT_TEST(Map, TaskId) (((Map)[(TaskId) / 64u] >> ((TaskId) % 64u)) & 1u)
+/* Ends the free slot list */
+#define FREE_NIL SCH_NO_TASK
+/* The free list top: an ABA tag in the upper half, the slot in the lower */
+#define FREE_TOP(Tag, TaskId) (((uint64_t)(Tag) << 32) | (uint32_t)(TaskId))
+/* A task id is its slot in the low ID_SLOT_BITS bits and the generation
+   of the slot above them (see Id_Make) */
+#define ID_SLOT_BITS (32u - (uint32_t)__builtin_clz(SCH_MAX_TASKS))
+#define ID_SLOT_MASK (((uint32_t)1 << ID_SLOT_BITS) - 1u)
+
+#if SCH_LAYOUT == SCH_LAYOUT_SOA
+#if SCH_ENGINE != SCH_ENGINE_LINEAR
+#error "SCH_LAYOUT_SOA needs SCH_ENGINE_LINEAR"
+#endif
+/* Delay lanes per vector: 32 bytes with AVX2, 16 with SSE2 or NEON */
+#if defined(__GNUC__) && defined(__AVX2__)
+#define SOA_LANES (32u / sizeof(Sch_Tick_t))
+#elif defined(__GNUC__)
+#define SOA_LANES (16u / sizeof(Sch_Tick_t))
+#else
+#define SOA_LANES 1u
+#endif
+#define SOA_IDLE ((Sch_Tick_t)~(Sch_Tick_t)0)
+#define TASK_DELAY(Sch, TaskId) ((Sch)->Delays[(TaskId) / SOA_LANES][(TaskId) % SOA_LANES])
+#else
+#define TASK_DELAY(Sch, TaskId) ((Sch)->Config[TaskId].Delay)
+#endif
 /**********************************************************************
 * Typedefs
 **********************************************************************/
+/**
+* How a task function is called.
+*/
+typedef enum
+{
+  TASK_PLAIN, /*< void (*)(void), Sch_AddTask */
+  TASK_CTX, /*< void (*)(void *), called with Ctx, Sch_AddTaskCtx */
+  TASK_BATCH /*< Sch_BatchTask_t, called with the due Ctx of its group */
+} TaskKind_t;
+
+#if SCH_LAYOUT == SCH_LAYOUT_SOA
+/**
+* SOA_LANES delays, a vector register when the compiler supports it.
+*/
+#if defined(__GNUC__)
+typedef Sch_Tick_t SoaVec_t __attribute__((vector_size(SOA_LANES * sizeof(Sch_Tick_t))));
+#else
+typedef Sch_Tick_t SoaVec_t[1];
+#endif
+#endif
+
 /**
 * Defines the scheduler configuration table’s elements that are used
 * by Sch_Init to configure the Scheduler Module.
@@ -34,20 +169,356 @@
 typedef struct 
 {
   void (*Task)(void); /*< a pointer to the task function */
-  uint16_t Delay; /*< Delay in ticks until the function runs */
-  uint32_t Period; /*< Interval (ticks) between subsequent runs. */
-  uint16_t RunMe; /*< Incremented (by scheduler) when task is due to execute */
+  void *Ctx; /*< The argument of a Sch_AddTaskCtx task */
+  uint8_t Kind; /*< TaskKind_t, how Task is called */
+  Sch_TaskId_t NextFree; /*< The next free slot, while this one is free (atomic accesses) */
+  Sch_TaskId_t Gen; /*< Bumped each time the slot is freed, tags its ids (atomic accesses) */
+#if SCH_LAYOUT == SCH_LAYOUT_AOS
+  Sch_Tick_t Delay; /*< Delay in ticks until the function runs */
+#endif
+  Sch_Tick_t Period; /*< Interval (ticks) between subsequent runs. */
+  Sch_Tick_t RunMe; /*< Incremented (by scheduler) when task is due to execute */
+  uint8_t Policy; /*< Sch_MissPolicy_t of the releases that come too late */
+  uint8_t Priority; /*< Dispatch priority, 0 is the highest */
+  uint32_t Missed; /*< Releases that came while a run was still pending */
+  uint32_t WcetUs; /*< Estimated run time used to balance the offsets */
+  uint8_t AutoDelay; /*< The offset is chosen by the scheduler */
+  uint8_t Event; /*< Released by Sch_PostEvent only, never by the clock */
+#if SCH_ENGINE == SCH_ENGINE_WHEEL
+  uint32_t Expiry; /*< Absolute tick at which the task is due next */
+  Sch_TaskId_t Next; /*< Next task in the same wheel slot */
+  Sch_TaskId_t Prev; /*< Previous task in the same wheel slot */
+  uint32_t Slot; /*< The wheel slot the task is linked in */
+#endif
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+  uint8_t Pinned; /*< Runs serially on its own core, never stolen */
+  _Atomic uint32_t InFlight; /*< Instances pushed to the deque and not run yet */
+#endif
+#if SCH_STATS
+  Sch_TaskStats_t Stats; /*< Run time statistics, MeanNs unused */
+#endif
+#if SCH_SHM
+  uint64_t Releases; /*< Runs released, published to the segment */
+  uint64_t Dispatches; /*< Runs started, published to the segment */
+#endif
 } TaskConfig_t;
+
+/**
+* The due instances of one batch task function in a dispatch round.
+*/
+typedef struct
+{
+  void (*Task)(void); /*< The batch function, NULL if the group is free */
+  uint32_t Count; /*< Instances in Entries */
+  TaskConfig_t *Entries[SCH_BATCH_MAX];
+} BatchGroup_t;
+
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+/**
+* A bounded Chase-Lev work-stealing deque of due task instances. Only
+* the owner thread pushes and takes at the bottom, any thread steals
+* from the top.
+*/
+typedef struct
+{
+  _Atomic int64_t Top; /*< The next entry to steal */
+  _Atomic int64_t Bottom; /*< The next free entry of the owner */
+  _Atomic(TaskConfig_t *) Buffer[SCH_DEQUE_SIZE];
+} Deque_t;
+
+/**
+* The outcome of a deque take or steal.
+*/
+typedef enum
+{
+  DEQUE_OK, /*< An entry is returned */
+  DEQUE_EMPTY, /*< There's nothing to take */
+  DEQUE_ABORT /*< Lost a race with another thread, worth retrying */
+} DequeStatus_t;
+#endif
+
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
+/**
+* An application file descriptor waited on by the scheduler loop.
+*/
+typedef struct
+{
+  int Fd; /*< The watched descriptor */
+  Sch_FdHandler_t Handler; /*< Called when Fd is ready, NULL if free */
+  void *Arg; /*< Passed to Handler */
+} FdEntry_t;
+#endif
+
+/**
+* A task table change posted by another thread.
+*/
+typedef enum
+{
+  CMD_ADD, /*< Start the reserved slot TaskId with Task, Delay, Period */
+  CMD_DELETE /*< Delete TaskId */
+} CmdKind_t;
+
+typedef struct
+{
+  _Atomic uint32_t Seq; /*< Position + 1 once written, + size once read */
+  uint8_t Kind; /*< CmdKind_t */
+  Sch_TaskId_t TaskId;
+  void (*Task)(void);
+  Sch_Tick_t Delay;
+  Sch_Tick_t Period;
+} CmdCell_t;
+
+/**
+* A bounded multi-producer single-consumer command queue: any thread
+* claims a cell with one CAS on Tail, only the instance thread reads.
+*/
+typedef struct
+{
+  CmdCell_t Cells[SCH_CMD_QUEUE_SIZE];
+  _Atomic uint32_t Tail; /*< The next cell to claim */
+  uint32_t Head; /*< The next cell to apply */
+} CmdQueue_t;
+
+/**
+* The state of one scheduler instance. Instance 0 is driven by the
+* Sch_* functions from the calling thread, every instance can also be
+* run by its own pinned worker thread (see Sch_StartCores). An instance
+* is only ever touched by the thread that runs it.
+*/
+typedef struct
+{
+  TaskConfig_t Config[SCH_MAX_TASKS]; /*< The task table */
+#if SCH_LAYOUT == SCH_LAYOUT_SOA
+  SoaVec_t Delays[LIVE_WORDS * 64u / SOA_LANES]; /*< Delay of every task */
+#endif
+  uint64_t Live[LIVE_WORDS]; /*< Bit TaskId % 64 of word TaskId / 64 set for a task */
+  uint64_t Ready[SCH_PRIORITIES][LIVE_WORDS]; /*< The same bit set while the task RunMe > 0, per priority */
+  uint64_t Timed[LIVE_WORDS]; /*< The same bit set while the clock releases the task */
+  _Atomic uint64_t Posted[LIVE_WORDS]; /*< Set by Sch_PostEvent from any context */
+  _Atomic uint64_t FreeTop; /*< FREE_TOP of the first free slot, FREE_NIL if the table is full */
+#if SCH_ENGINE == SCH_ENGINE_TABLE
+  _Atomic uint64_t TableFree[LIVE_WORDS]; /*< The same bit set while a schedule table slot is free, those never go in the free list */
+#endif
+  CmdQueue_t Commands; /*< Table changes posted by other threads */
+  uint32_t TickNow; /*< The tick that will be processed next */
+  Sch_IdleStats_t IdleStats;
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
+  int TimerFd; /*< The timerfd waking up the instance thread */
+  int WakeFd; /*< eventfd used to wake the instance thread up */
+  int EpollFd; /*< Waits on TimerFd, WakeFd and Fds */
+  uint64_t PendingTicks; /*< Timer expirations not processed yet */
+  FdEntry_t Fds[SCH_MAX_FDS]; /*< The application descriptors */
+#else
+  timer_t Timer; /*< The timer waking up the instance thread */
+#endif
+  uint8_t HasTimer; /*< Timer is created */
+#if SCH_ENGINE == SCH_ENGINE_WHEEL
+  Sch_TaskId_t Wheel[WHEEL_SLOTS]; /*< Heads of the wheel slot lists */
+#elif SCH_ENGINE == SCH_ENGINE_TABLE
+  uint32_t TableIndex; /*< The schedule table entry of TickNow */
+#endif
+#if SCH_CLOCK_DRIVEN || SCH_STATS
+  uint64_t Epoch; /*< CLOCKID time of tick 0, in ns, 0 until started */
+#endif
+#if SCH_STATS
+  Sch_Stats_t Stats; /*< Dispatch statistics, LatencyMeanNs unused */
+#endif
+#if SCH_SHM
+  uint64_t Rounds; /*< Dispatch rounds, published to the segment */
+#endif
+#if SCH_TRACE
+  Sch_TraceEvent_t Trace[SCH_TRACE_SIZE]; /*< The most recent events */
+  _Atomic uint64_t TraceHead; /*< Events recorded since Sch_Init, the next one goes to Trace[TraceHead & TRACE_MASK] */
+#endif
+  BatchGroup_t Batches[SCH_BATCH_GROUPS]; /*< Batch tasks due this round */
+  void *BatchCtx[SCH_BATCH_MAX]; /*< The contexts of the group being run */
+#if SCH_RT
+  Sch_RtReport_t RtReport; /*< What the real-time start path got */
+#endif
+  pthread_t Thread; /*< The thread running the instance, once started */
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+  Deque_t Deque; /*< Due task instances other workers may steal */
+  uint64_t Doomed[LIVE_WORDS]; /*< The same bit set for a deleted task whose slot waits for its stolen runs */
+#endif
+} Sch_t;
+
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+_Static_assert((SCH_DEQUE_SIZE & DEQUE_MASK) == 0, "SCH_DEQUE_SIZE must be a power of 2");
+#endif
+_Static_assert((SCH_CMD_QUEUE_SIZE & CMD_MASK) == 0, "SCH_CMD_QUEUE_SIZE must be a power of 2");
+#if SCH_TRACE
+_Static_assert((SCH_TRACE_SIZE & TRACE_MASK) == 0, "SCH_TRACE_SIZE must be a power of 2");
+_Static_assert(SCH_MAX_CORES <= 256, "Sch_TraceEvent_t holds 8-bit instance indexes");
+#endif
+#if SCH_SIM
+#if !SCH_STATS
+#error "SCH_BACKEND_SIM needs SCH_STATS"
+#endif
+_Static_assert(SCH_MAX_CORES == 1 && SCH_DISPATCH == SCH_DISPATCH_SERIAL,
+               "SCH_BACKEND_SIM runs a single serial instance");
+#endif
+#if SCH_ENGINE == SCH_ENGINE_TABLE
+_Static_assert(SCH_TABLE_TASKS <= SCH_MAX_TASKS, "the schedule table has more tasks than SCH_MAX_TASKS");
+#endif
+/* SCH_NO_TASK must never be a valid task id */
+_Static_assert(SCH_MAX_TASKS < SCH_NO_TASK, "Sch_TaskId_t is too narrow for SCH_MAX_TASKS");
+/* Sch_PostEvent is called from signal handlers */
+_Static_assert(__atomic_always_lock_free(sizeof(uint64_t), 0), "Sch_PostEvent needs lock-free 64-bit atomics");
 /**********************************************************************
 * Module Variable Definitions
 **********************************************************************/
-static TaskConfig_t Config[SCH_MAX_TASKS];
-static timer_t timerid;
+static Sch_t Instances[SCH_MAX_CORES];
+static uint32_t CoresStarted; /*< The number of worker threads running */
+static atomic_int CoresStop; /*< Asks the worker threads to return */
+#if SCH_ENGINE != SCH_ENGINE_TABLE
+/*< Scratch per-tick load profile of Sch_AddTaskAuto and Sch_Rebalance, in us */
+static uint32_t BalanceLoad[SCH_BALANCE_MAX_HYPER];
+#endif
+#if SCH_BACKEND == SCH_BACKEND_SIGNAL
+/*< Set by TimerHandler when the timer (not a steal kick or another
+ *  signal) woke the thread */
+static __thread volatile sig_atomic_t TimerFired;
+#endif
+#if SCH_CLOCK_DRIVEN && SCH_BACKEND == SCH_BACKEND_SIGNAL
+static sigset_t SleepMask; /*< The signal mask while sleeping: TIMER_SIG unblocked */
+#endif
+#if SCH_SHM
+static uint8_t *Shm; /*< The statistics segment, NULL until Sch_ShmOpen */
+static size_t ShmSize; /*< Its size in bytes */
+static char ShmName[NAME_MAX]; /*< Its name, unlinked by Sch_Deinit */
+#endif
+#if SCH_TRACE && SCH_TRACE_SIGNAL
+static volatile sig_atomic_t TraceRequested; /*< Set by SCH_TRACE_SIGNAL */
+#endif
+#if SCH_SIM
+static uint64_t SimNowNs = SIM_EPOCH_NS; /*< The virtual clock */
+static uint64_t SimWakeNs; /*< When the current dispatch round started */
+static uint64_t SimBusyNs; /*< Task run time charged to the clock */
+static uint64_t SimRoundMaxNs; /*< The longest dispatch round */
+static uint32_t SimRoundMaxTick; /*< The tick it served */
+static uint64_t SimLateRounds; /*< Rounds that ended past the next tick */
+static uint64_t SimHostNs; /*< Host time spent in Sch_SimRun */
+#if SCH_TRACE
+static FILE *SimTrace; /*< The file of Sch_SimTrace, NULL if none */
+static uint64_t SimFlushed; /*< The events already written to it */
+static Sch_TraceBlock_t SimBlock; /*< Its single block, rewritten by every synced flush */
+#endif
+#endif
 /**********************************************************************
 * Function Prototypes
 **********************************************************************/
-static void Sch_GoToSleep(void);
+static void Ctx_Init(Sch_t *Sch);
+static Sch_TaskId_t Ctx_AddTask(Sch_t *Sch, void (*Function)(void),
+                                const Sch_Tick_t Delay, const Sch_Tick_t Period,
+                                const Sch_MissPolicy_t Policy, const uint8_t Event);
+static inline void Ctx_Release(Sch_t *Sch, const uint32_t TaskId, const Sch_Tick_t Count);
+#if SCH_ENGINE != SCH_ENGINE_TABLE
+static uint32_t Ctx_LoadProfile(Sch_t *Sch, const Sch_Tick_t Period, const uint8_t Fixed);
+static uint32_t Ctx_BestPhase(const uint32_t Horizon, const Sch_Tick_t Period,
+                              const uint32_t WcetUs);
+static void Ctx_AddLoad(const uint32_t Horizon, const uint32_t Phase,
+                        const Sch_Tick_t Period, const uint32_t WcetUs);
+static void Ctx_SetPhase(Sch_t *Sch, const uint32_t TaskId, const uint32_t Phase);
+static uint32_t Ctx_Phase(Sch_t *Sch, const uint32_t TaskId);
+#endif
+static void Ctx_DeleteTask(Sch_t *Sch, const Sch_TaskId_t TaskId);
+static void Ctx_StartTask(Sch_t *Sch, const uint32_t TaskId, void (*Function)(void),
+                          const Sch_Tick_t Delay, const Sch_Tick_t Period,
+                          const Sch_MissPolicy_t Policy, const uint8_t Event);
+static uint32_t Free_Pop(Sch_t *Sch);
+static uint32_t Free_Take(Sch_t *Sch, const Sch_Tick_t Delay,
+                          const Sch_Tick_t Period, const uint8_t Event);
+static void Free_Push(Sch_t *Sch, const uint32_t TaskId);
+static Sch_TaskId_t Id_Make(Sch_t *Sch, const uint32_t TaskId);
+static uint32_t Id_Slot(Sch_t *Sch, const Sch_TaskId_t TaskId);
+static int Cmd_Post(Sch_t *Sch, const CmdKind_t Kind, const uint32_t TaskId,
+                    void (*Function)(void), const Sch_Tick_t Delay, const Sch_Tick_t Period);
+static void Ctx_ApplyCommands(Sch_t *Sch);
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+static void Ctx_Reap(Sch_t *Sch);
+#endif
+static void Ctx_ClearTask(Sch_t *Sch, const uint32_t TaskId);
+static void Ctx_Start(Sch_t *Sch, const pid_t ThreadId);
+static void Ctx_Update(Sch_t *Sch);
+static void Ctx_Tick(Sch_t *Sch);
+static void Ctx_Advance(Sch_t *Sch, const uint32_t Ticks);
+#if SCH_LAYOUT == SCH_LAYOUT_SOA
+static uint64_t Soa_Tick(SoaVec_t *Delays);
+#endif
+static void Ctx_Dispatch(Sch_t *Sch);
+static void Ctx_TakePosted(Sch_t *Sch);
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
+static uint8_t Ctx_HasPosted(Sch_t *Sch);
+#endif
+static void Ctx_Run(Sch_t *Sch, TaskConfig_t *Entry);
+static inline void Ctx_Call(TaskConfig_t *Entry);
+static void Ctx_Batch(Sch_t *Sch, TaskConfig_t *Entry);
+static void Ctx_RunBatch(Sch_t *Sch, BatchGroup_t *Group);
+static void Ctx_Ungroup(Sch_t *Sch, const TaskConfig_t *Entry);
+#if SCH_DISPATCH_BUDGET_US
+static void Ctx_Unbatch(Sch_t *Sch, BatchGroup_t *Group);
+static uint8_t Ctx_OverBudget(Sch_t *Sch, const uint64_t Start);
+#endif
+static void Ctx_GoToSleep(Sch_t *Sch);
+static void *Core_Main(void *Arg);
+static void Ctx_Wake(Sch_t *Sch);
+#if SCH_RT
+static void Ctx_RtSetup(Sch_t *Sch, const int Cpu);
+static Sch_RtStatus_t Rt_Report(const uint32_t Core, const char *Step, const int Error);
+static void Rt_Prefault(void);
+#endif
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
+static void Ctx_Open(Sch_t *Sch);
+static void Ctx_HandleEvents(Sch_t *Sch, struct epoll_event *Events, int Count);
+#endif
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+static void Ctx_Steal(Sch_t *Sch);
+static void Ctx_Kick(Sch_t *Sch);
+static uint8_t Deque_Push(Deque_t *Deque, TaskConfig_t *Entry);
+static DequeStatus_t Deque_Take(Deque_t *Deque, TaskConfig_t **Entry);
+static DequeStatus_t Deque_Steal(Deque_t *Deque, TaskConfig_t **Entry);
+#endif
+#if SCH_CLOCK_DRIVEN || SCH_STATS || SCH_DISPATCH_BUDGET_US
+static uint64_t Sch_NowNs(void);
+#endif
+#if SCH_SIM
+static uint64_t Sim_HostNs(void);
+static void Sim_Charge(const uint64_t CostNs, const uint64_t HostStart);
+static void Sim_Sleep(Sch_t *Sch, const uint64_t Deadline);
+#if SCH_TRACE
+static void Sim_Flush(Sch_t *Sch, const uint8_t Sync);
+#endif
+#endif
+#if SCH_TICKLESS
+static uint32_t Ctx_NextDue(Sch_t *Sch);
+#endif
+#if SCH_STATS
+static void Stats_Record(Sch_TaskStats_t *Stats, const uint64_t Ns);
+static void Stats_Min(uint64_t *Min, const uint64_t Value);
+static void Stats_Max(uint64_t *Max, const uint64_t Value);
+#endif
+#if SCH_SHM
+static void Shm_PublishTask(Sch_t *Sch, const uint32_t TaskId);
+static void Shm_PublishCore(Sch_t *Sch);
+#endif
+#if SCH_TRACE
+static inline uint64_t Trace_Now(void);
+static inline void Trace_Record(Sch_t *Sch, const Sch_TraceType_t Type, const uint32_t Id,
+                                const uint32_t Arg, const uint8_t Owner, const uint64_t Ns);
+static uint32_t Trace_TaskId(const TaskConfig_t *Entry, uint8_t *Owner);
+#if SCH_TRACE_SIGNAL
+static void TraceHandler(int Signal);
+static void Trace_DumpRequested(Sch_t *Sch);
+#endif
+#endif
+#if SCH_BACKEND == SCH_BACKEND_SIGNAL
 static void TimerHandler(int, siginfo_t*, void*);
+#endif
+#if SCH_ENGINE == SCH_ENGINE_WHEEL
+static void Wheel_Insert(Sch_t *Sch, const uint32_t TaskId);
+static void Wheel_Remove(Sch_t *Sch, const uint32_t TaskId);
+static uint32_t Wheel_Cascade(Sch_t *Sch, const uint32_t Level, const uint32_t Index);
+#endif
 /**********************************************************************
 * Function Definitions
 **********************************************************************/
@@ -71,15 +542,43 @@ static void TimerHandler(int, siginfo_t*, void*);
 **********************************************************************/
 void Sch_Init(void)
 {
-  uint8_t TaskIndex;
-  struct sigevent sev;
-  struct sigaction sa;
+  uint32_t Core;
 
-  //set the task parameters.
-  for (TaskIndex = 0; TaskIndex < SCH_MAX_TASKS; TaskIndex++)
+  //set the task parameters of every instance.
+  for (Core = 0; Core < SCH_MAX_CORES; Core++)
+    {
+      Ctx_Init(&Instances[Core]);
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
+      Ctx_Open(&Instances[Core]);
+#endif
+    }
+  CoresStarted = 0;
+  atomic_store(&CoresStop, 0);
+#if SCH_SIM
+  // The virtual clock keeps running, only the report starts over
+  SimBusyNs = 0;
+  SimRoundMaxNs = 0;
+  SimRoundMaxTick = 0;
+  SimLateRounds = 0;
+  SimHostNs = 0;
+#endif
+
+#if SCH_TRACE && SCH_TRACE_SIGNAL
+  struct sigaction TraceAction;
+
+  // Without SA_RESTART, so the signal also ends the sleep of the thread
+  TraceAction.sa_flags = 0;
+  TraceAction.sa_handler = TraceHandler;
+  sigemptyset(&TraceAction.sa_mask);
+  if (sigaction(SCH_TRACE_SIGNAL, &TraceAction, NULL) == -1)
     {
-      Sch_DeleteTask(TaskIndex);
+      perror("sigaction");
+      exit(EXIT_FAILURE);
     }
+#endif
+
+#if SCH_BACKEND == SCH_BACKEND_SIGNAL
+  struct sigaction sa;
 
   //init the timer used for the scheduler.
 
@@ -93,282 +592,5068 @@ void Sch_Init(void)
       exit(EXIT_FAILURE);
     }
 
-  /* Create the timer */
-  sev.sigev_notify = SIGEV_SIGNAL;
-  sev.sigev_signo = TIMER_SIG;
-  sev.sigev_value.sival_ptr = &timerid;
-  if (timer_create(CLOCKID, &sev, &timerid) == -1)
+#if SCH_CLOCK_DRIVEN
+  /* The timer is one-shot: a signal that arrives before the scheduler
+  sleeps must stay pending instead of being lost, so it's only unblocked
+  atomically by sigsuspend in Ctx_GoToSleep. Worker threads inherit it. */
+  sigset_t TimerMask;
+  sigemptyset(&TimerMask);
+  sigaddset(&TimerMask, TIMER_SIG);
+  if (pthread_sigmask(SIG_BLOCK, &TimerMask, &SleepMask) != 0)
     {
-      perror("timer_create");
+      perror("pthread_sigmask");
       exit(EXIT_FAILURE);
     }
+  sigdelset(&SleepMask, TIMER_SIG);
+#endif
+#endif
 }
 
 /*********************************************************************
-* Function : Sch_DispatchTasks()
+* Function : Ctx_Init()
 *//**
 * \b Description:
-* Utility function is used to dispatch/call the tasks that're due to run.
+* Utility function used to reset one scheduler instance: no tasks,
+* no timer, the tick counter back to 0.
 *
-* PRE-CONDITION: Sch_Init() is called <br>
-* PRE-CONDITION: Any task duration must < tick <br>
-* POST-CONDITION: If There's a task that's due will run. 
+* @param Sch the scheduler instance.
 *
 * @return void
 *
-* \b Example:
-* @code
-* Sch_Init();
-* @endcode
-*
 * @see Sch_Init
 **********************************************************************/
-void Sch_DispatchTasks(void)
+static void Ctx_Init(Sch_t *Sch)
 {
-  uint8_t TaskId;
-  
-  // Dispatches (runs) the next task (if one is ready)
-  for (TaskId = 0; TaskId < SCH_MAX_TASKS; TaskId++)
+  uint32_t TaskIndex, First = 0;
+
+  for (TaskIndex = 0; TaskIndex < SCH_MAX_TASKS; TaskIndex++)
     {
-      if (Config[TaskId].Task != NULL && Config[TaskId].RunMe > 0)
-        {
-          (*Config[TaskId].Task)(); // Run the task
-          Config[TaskId].RunMe -= 1; // Reset / reduce RunMe flag
-        }
+      Ctx_ClearTask(Sch, TaskIndex);
+      // The free slots are handed out lowest first
+      Sch->Config[TaskIndex].NextFree = TaskIndex + 1 < SCH_MAX_TASKS ? TaskIndex + 1 : FREE_NIL;
+    }
+#if SCH_ENGINE == SCH_ENGINE_TABLE
+  // The schedule table slots are taken by their delay and period (see Free_Take)
+  for (TaskIndex = 0; TaskIndex < LIVE_WORDS; TaskIndex++)
+    {
+      atomic_store(&Sch->TableFree[TaskIndex], 0);
     }
+  for (TaskIndex = 0; TaskIndex < SCH_TABLE_TASKS; TaskIndex++)
+    {
+      atomic_fetch_or(&Sch->TableFree[TaskIndex / 64u], (uint64_t)1 << (TaskIndex % 64u));
+    }
+  First = SCH_TABLE_TASKS;
+#endif
+  atomic_store(&Sch->FreeTop, FREE_TOP(0, First < SCH_MAX_TASKS ? First : FREE_NIL));
+  for (TaskIndex = 0; TaskIndex < SCH_CMD_QUEUE_SIZE; TaskIndex++)
+    {
+      atomic_store(&Sch->Commands.Cells[TaskIndex].Seq, TaskIndex);
+    }
+  atomic_store(&Sch->Commands.Tail, 0);
+  Sch->Commands.Head = 0;
+#if SCH_LAYOUT == SCH_LAYOUT_SOA
+  // The lanes past the last task are never used
+  for (; TaskIndex < LIVE_WORDS * 64u; TaskIndex++)
+    {
+      TASK_DELAY(Sch, TaskIndex) = SOA_IDLE;
+    }
+#endif
+
+#if SCH_ENGINE == SCH_ENGINE_WHEEL
+  for (TaskIndex = 0; TaskIndex < WHEEL_SLOTS; TaskIndex++)
+    {
+      Sch->Wheel[TaskIndex] = WHEEL_NIL;
+    }
+#elif SCH_ENGINE == SCH_ENGINE_TABLE
+  Sch->TableIndex = 0;
+#endif
+  for (TaskIndex = 0; TaskIndex < SCH_BATCH_GROUPS; TaskIndex++)
+    {
+      Sch->Batches[TaskIndex].Task = NULL;
+      Sch->Batches[TaskIndex].Count = 0;
+    }
+  Sch->TickNow = 0;
+  Sch->IdleStats.Ticks = 0;
+  Sch->IdleStats.Wakeups = 0;
+  Sch->HasTimer = 0;
+#if SCH_CLOCK_DRIVEN || SCH_STATS
+  Sch->Epoch = 0;
+#endif
+#if SCH_STATS
+  Sch->Stats = (Sch_Stats_t){ .LatencyMinNs = UINT64_MAX };
+#endif
+#if SCH_SHM
+  Sch->Rounds = 0;
+#endif
+#if SCH_TRACE
+  atomic_store(&Sch->TraceHead, 0);
+#endif
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+  atomic_store(&Sch->Deque.Top, 0);
+  atomic_store(&Sch->Deque.Bottom, 0);
+  // The instances left in the deque are dropped with it
+  for (TaskIndex = 0; TaskIndex < SCH_MAX_TASKS; TaskIndex++)
+    {
+      atomic_store(&Sch->Config[TaskIndex].InFlight, 0);
+    }
+#endif
 }
+
 /*********************************************************************
-* Function : Sch_GoToSleep()
+* Function : Sch_DispatchTasks()
 *//**
 * \b Description:
-* Utility function used to make CPU enter sleep mode. It's invoked inside Sch_DispatchTasks
+* Utility function is used to dispatch/call the tasks that're due to run.
 *
 * PRE-CONDITION: Sch_Init() is called <br>
-* POST-CONDITION: The CPU enters into sleep mode.
+* PRE-CONDITION: Any task duration must < tick <br>
+* POST-CONDITION: If There's a task that's due will run. 
 *
 * @return void
 *
 * \b Example:
 * @code
 * Sch_Init();
-* Sch_DispatchTasks();
 * @endcode
 *
 * @see Sch_Init
-* @see Sch_DispatchTasks
-*
 **********************************************************************/
-static void Sch_GoToSleep(void)
+void Sch_DispatchTasks(void)
 {
-  pause();
+  Ctx_Dispatch(&Instances[0]);
 }
 
 /*********************************************************************
-* Function : Sch_AddTask()
+* Function : Ctx_Dispatch()
 *//**
 * \b Description:
+* Utility function used to dispatch the due tasks of one instance.
+* In the work-stealing mode the whole RunMe backlog of the tasks that
+* aren't pinned is pushed to the instance deque then drained, while
+* idle workers steal from it. Pinned tasks keep running one instance
+* per round on their own core. The batch instances of a priority level
+* run in groups once the level is done, before the next one.
 *
-* This function is used to add task to the scheduler. 
-*
-* PRE-CONDITION: Sch_Init() is called <br>
-* POST-CONDITION: The task will be added to the scheduler.
-*
-* @param Function a function pointer to the task function.
-* @param Delay a delay before the function executed for its first time
-* @param Period the period of the task
-*
-* @return uint8_t the id of the task
-*
-* \b Example:
-* @code
-* Sch_Init();
-* Sch_AddTask(count, 0, 10); // Make a task starting at 0 tick with period 10 ticks. 
-* @endcode
+* @param Sch the scheduler instance.
 *
-* @see Sch_Init
+* @return void
 *
+* @see Sch_DispatchTasks
 **********************************************************************/
-uint8_t Sch_AddTask(void (*Function)(),
-      const uint32_t Delay,
-      const uint32_t Period)
+static void Ctx_Dispatch(Sch_t *Sch)
 {
-  uint8_t TaskId = 0;
+  TaskConfig_t *Config = Sch->Config;
+  uint32_t TaskId, Word, Level;
+  uint64_t Bits;
+  uint8_t Spent = 0;
+#if SCH_DISPATCH_BUDGET_US
+  const uint64_t Start = Sch_NowNs();
+#endif
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+  TaskConfig_t *Entry;
+  uint32_t Pushed = 0;
+#endif
+  
+  Ctx_TakePosted(Sch);
 
-  // First find a gap in the array (if there is one)
-  while ((Config[TaskId].Task != NULL) && (TaskId < SCH_MAX_TASKS))
+  // Dispatches (runs) the next task (if one is ready), the highest
+  // priority first
+  for (Level = 0; Level < SCH_PRIORITIES && !Spent; Level++)
     {
-      TaskId++;
+      for (Word = 0; Word < LIVE_WORDS && !Spent; Word++)
+        {
+          for (Bits = Sch->Ready[Level][Word]; Bits != 0 && !Spent; Bits &= Bits - 1)
+            {
+              TaskId = Word * 64u + (uint32_t)__builtin_ctzll(Bits);
+#if SCH_DISPATCH_BUDGET_US
+              // Priority 0 always runs, the rest of the round waits for the
+              // next one (keeping RunMe) once the budget is spent
+              if (Level > 0 && Ctx_OverBudget(Sch, Start))
+                {
+                  Spent = 1;
+#if SCH_SHM
+                  Shm_PublishTask(Sch, TaskId);
+#endif
+                  continue;
+                }
+#endif
+              // A task run earlier in this round may have deleted this one
+              if (Config[TaskId].Task != NULL && Config[TaskId].RunMe > 0)
+                {
+#if SCH_STATS
+                  // Every pending run but the next one waits for a later round
+                  Sch->Stats.Backlog += Config[TaskId].RunMe - 1;
+                  if (Config[TaskId].RunMe > Sch->Stats.MaxBacklog)
+                    {
+                      Sch->Stats.MaxBacklog = Config[TaskId].RunMe;
+                    }
+#endif
+                  if (Config[TaskId].Kind == TASK_BATCH)
+                    {
+                      // Runs with the other due instances of its function below
+                      Ctx_Batch(Sch, &Config[TaskId]);
+                    }
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+                  // One-shot and event tasks run on their own core
+                  else if (!Config[TaskId].Pinned && Config[TaskId].Period != 0)
+                    {
+                      // A full deque leaves the rest of the backlog for next round
+                      // Counted before the push, a thief may run it right away
+                      while (Config[TaskId].RunMe > 0)
+                        {
+                          atomic_fetch_add_explicit(&Config[TaskId].InFlight, 1,
+                                                    memory_order_relaxed);
+                          if (!Deque_Push(&Sch->Deque, &Config[TaskId]))
+                            {
+                              atomic_fetch_sub_explicit(&Config[TaskId].InFlight, 1,
+                                                        memory_order_relaxed);
+                              break;
+                            }
+                          Config[TaskId].RunMe -= 1;
+                          Pushed++;
+                        }
+                    }
+#endif
+                  else
+                    {
+                      do
+                        {
+                          Ctx_Run(Sch, &Config[TaskId]); // Run the task
+                          Config[TaskId].RunMe -= 1; // Reset / reduce RunMe flag
+                        }
+                      while (Config[TaskId].Policy == SCH_MISS_CATCH_UP &&
+                             Config[TaskId].RunMe > 0);
+                    }
+#if SCH_SHM
+                  Shm_PublishTask(Sch, TaskId);
+#endif
+                  // A one-shot task runs once, even if it was posted too,
+                  // then frees its slot
+                  if (Config[TaskId].Task != NULL && Config[TaskId].Period == 0 &&
+                      !Config[TaskId].Event)
+                    {
+                      Ctx_DeleteTask(Sch, TaskId);
+                    }
+                  // Back out of the ready mask once every pending run is out
+                  else if (Config[TaskId].RunMe == 0)
+                    {
+                      BIT_CLEAR(Sch->Ready[Config[TaskId].Priority], TaskId);
+                    }
+                }
+            }
+        }
+      // The batch groups of a level run before the next level, under the
+      // same budget: past it their instances get their runs back
+      for (TaskId = 0; TaskId < SCH_BATCH_GROUPS; TaskId++)
+        {
+#if SCH_DISPATCH_BUDGET_US
+          if (!Spent && Level > 0 && Sch->Batches[TaskId].Count != 0 &&
+              Ctx_OverBudget(Sch, Start))
+            {
+              Spent = 1;
+            }
+          if (Spent)
+            {
+              Ctx_Unbatch(Sch, &Sch->Batches[TaskId]);
+            }
+#endif
+          Ctx_RunBatch(Sch, &Sch->Batches[TaskId]);
+          Sch->Batches[TaskId].Task = NULL;
+        }
     }
 
-  // If we're here, there is a space in the task array
-  Config[TaskId].Task = Function;
-  Config[TaskId].Delay = Delay;
-  Config[TaskId].Period = Period;
-  Config[TaskId].RunMe = 0;
-
-  return TaskId;
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+  if (Pushed > 1)
+    {
+      // There's a backlog, wake the idle workers up to share it
+      Ctx_Kick(Sch);
+    }
+  // Drain our own deque, then help the other workers with theirs
+  while (Deque_Take(&Sch->Deque, &Entry) != DEQUE_EMPTY)
+    {
+      if (Entry != NULL)
+        {
+          Ctx_Run(Sch, Entry);
+          atomic_fetch_sub_explicit(&Entry->InFlight, 1, memory_order_release);
+        }
+    }
+  Ctx_Steal(Sch);
+#endif
+#if SCH_SHM
+  Sch->Rounds++;
+  Shm_PublishCore(Sch);
+#endif
 }
 
 /*********************************************************************
-* Function : Sch_DeleteTask()
+* Function : Ctx_TakePosted()
 *//**
 * \b Description:
+* Utility function used to release the tasks posted since the last
+* dispatch round.
 *
-* This function is used to delete a task from the scheduler. 
-*
-* PRE-CONDITION: Sch_Init() is called <br>
-* POST-CONDITION: The task will be deleted.
-*
-* @param TaskId The id of the task to be deleted.
+* @param Sch the scheduler instance.
 *
 * @return void
 *
-* \b Example:
-* @code
-* Sch_Init();
-* uint8_t taskId = Sch_AddTask(count, 0, 10); 
-* Sch_DeleteTask(taskId);
-* @endcode
-*
-* @see Sch_Init
-* @see Sch_AddTask
-*
+* @see Sch_PostEvent
 **********************************************************************/
-void Sch_DeleteTask(const uint8_t TaskId)
+static void Ctx_TakePosted(Sch_t *Sch)
 {
-  Config[TaskId].Task = NULL;
-  Config[TaskId].Delay = 0;
-  Config[TaskId].Period = 0;
-  Config[TaskId].RunMe = 0;
+  uint32_t TaskId, Word;
+  uint64_t Bits;
+
+  for (Word = 0; Word < LIVE_WORDS; Word++)
+    {
+      // Only the words with a post pay for the exchange
+      if (atomic_load_explicit(&Sch->Posted[Word], memory_order_relaxed) == 0)
+        {
+          continue;
+        }
+      Bits = atomic_exchange_explicit(&Sch->Posted[Word], 0, memory_order_acquire);
+      for (Bits &= Sch->Live[Word]; Bits != 0; Bits &= Bits - 1)
+        {
+          TaskId = Word * 64u + (uint32_t)__builtin_ctzll(Bits);
+          Ctx_Release(Sch, TaskId, 1);
+        }
+    }
 }
 
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
 /*********************************************************************
-* Function : Sch_Update()
+* Function : Ctx_HasPosted()
 *//**
 * \b Description:
+* Utility function used to check for posts not taken yet.
 *
-* this function used to schedule the tasks at every tick. 
-*
-* PRE-CONDITION: Sch_Init() is called <br>
-* POST-CONDITION: The tasks are scheduled according to their configuration.
-*
-* @return void
-*
-* \b Example:
-* @code
-* Sch_Init();
-*
-* TimerHandler {
-*   Sch_Update();
-* }
-* @endcode
+* @param Sch the scheduler instance.
 *
-* @see Sch_Init
+* @return uint8_t 1 if a task is posted.
 *
+* @see Ctx_GoToSleep
 **********************************************************************/
-void Sch_Update(void)
+static uint8_t Ctx_HasPosted(Sch_t *Sch)
 {
-  uint8_t Index;
-  for (Index = 0; Index < SCH_MAX_TASKS; Index++)
+  uint32_t Word;
+
+  for (Word = 0; Word < LIVE_WORDS; Word++)
     {
-      // Check if there is a task at this location
-      if (Config[Index].Task != NULL)
+      if (atomic_load_explicit(&Sch->Posted[Word], memory_order_relaxed) != 0)
         {
-          if (Config[Index].Delay == 0)
-            {
-              // The task is due to run
-              Config[Index].RunMe += 1; 
-              // Schedule periodic tasks to run again
-              Config[Index].Delay = Config[Index].Period - 1;
-            }
-          else
-            {
-              // Not yet ready to run: just decrement the delay
-              Config[Index].Delay -= 1;
-            }
+          return 1;
         }
     }
-  
-  Sch_DispatchTasks();
-
-  // The scheduler enters idle mode at this point
-  Sch_GoToSleep();
+  return 0;
 }
+#endif
 
 /*********************************************************************
-* Function : Sch_Start()
+* Function : Ctx_Run()
 *//**
 * \b Description:
+* Utility function used to run one due task instance. With SCH_STATS
+* the run is timed into the task statistics and its latency from the
+* nominal time of the tick being processed into the ones of Sch.
 *
-* This function is used to start the schedule module. 
-*
-* PRE-CONDITION: Sch_Init() is called <br>
-* POST-CONDITION: The scheduler starts.
+* @param Sch the scheduler instance of the running thread.
+* @param Entry the task to run, it may belong to another instance.
 *
 * @return void
 *
-* \b Example:
-* @code
-* Sch_Init();
-* Sch_AddTask(count, 0, 10);
-* Sch_Start();
-* @endcode
-*
-* @see Sch_Init
-*
+* @see Ctx_Dispatch
 **********************************************************************/
-void Sch_Start(void)
-{ 
-  struct itimerspec its;    
-  /* Start the timer */
-  its.it_value.tv_sec = 0;
-  its.it_value.tv_nsec = TICK * 1000000;
-  its.it_interval.tv_sec = its.it_value.tv_sec;
-  its.it_interval.tv_nsec = its.it_value.tv_nsec;
+static void Ctx_Run(Sch_t *Sch, TaskConfig_t *Entry)
+{
+#if SCH_TRACE
+  uint8_t Owner;
+  const uint32_t TaskId = Trace_TaskId(Entry, &Owner);
+  uint64_t TraceStart = Trace_Now(), TraceEnd;
 
-  if (timer_settime(timerid, 0, &its, NULL) == -1)
+  Trace_Record(Sch, SCH_TRACE_RUN_START, TaskId, 1, Owner, TraceStart);
+#endif
+#if SCH_SHM
+  STATS_ADD(Entry->Dispatches, 1);
+#endif
+#if SCH_STATS
+  uint64_t Start = Sch_NowNs();
+  uint64_t Latency;
+
+  Sch->Stats.Dispatches++;
+  // Sch_Tick/Sch_Advance driven instances have no tick time to refer to
+  if (Sch->Epoch != 0 && Sch->TickNow > 0)
     {
-      perror("timer_settime");
-      exit(EXIT_FAILURE);
+      Latency = Start - (Sch->Epoch + (uint64_t)(Sch->TickNow - 1) * NS_PER_TICK);
+      // A run started before the tick edge (clock jitter) counts as 0
+      if ((int64_t)Latency < 0)
+        {
+          Latency = 0;
+        }
+      Sch->Stats.LatencyTotalNs += Latency;
+      Sch->Stats.LatencySamples++;
+      if (Latency < Sch->Stats.LatencyMinNs)
+        {
+          Sch->Stats.LatencyMinNs = Latency;
+        }
+      if (Latency > Sch->Stats.LatencyMaxNs)
+        {
+          Sch->Stats.LatencyMaxNs = Latency;
+        }
+    }
+
+#if SCH_SIM
+  const uint64_t HostStart = Sim_HostNs();
+#endif
+
+  Ctx_Call(Entry);
+#if SCH_SIM
+  Sim_Charge((uint64_t)Entry->WcetUs * 1000u, HostStart);
+#endif
+
+  Stats_Record(&Entry->Stats, Sch_NowNs() - Start);
+#else
+  (void)Sch;
+  Ctx_Call(Entry);
+#endif
+#if SCH_TRACE
+  TraceEnd = Trace_Now();
+  Trace_Record(Sch, SCH_TRACE_RUN_END, TaskId, 1, Owner, TraceEnd);
+  if (TraceEnd - TraceStart > NS_PER_TICK)
+    {
+      Trace_Record(Sch, SCH_TRACE_OVERRUN, TaskId, 1, Owner, TraceEnd);
     }
+#endif
 }
 
 /*********************************************************************
-* Function : TimerHandler()
+* Function : Ctx_Call()
 *//**
 * \b Description:
+* Utility function used to call a task function, with its context if it
+* was added with Sch_AddTaskCtx.
 *
-* Utility function: a handler for the realtime Timer overrunning. It uses SIGRTMIN signal.
-*
-* PRE-CONDITION: Sch_Init() is called <br>
-* PRE-CONDITION: SIGRTMIN is binded to this handler
-*
-* POST-CONDITION: A scheduler tick happens.
-*
-* @param sig SIGRTMIN signal number
-* @param si information from the signal sender
-* @param uc the context of signal
+* @param Entry the task to call.
 *
 * @return void
 *
-* @see Sch_Init
+* @see Ctx_Run
 **********************************************************************/
-static void
-TimerHandler(int sig, siginfo_t *si, void *uc)
+static inline void Ctx_Call(TaskConfig_t *Entry)
 {
-  //Do nothing, just wake up the CPU
+  // Converted back to the type it was added with
+  if (Entry->Kind == TASK_CTX)
+    {
+      (*(void (*)(void *))Entry->Task)(Entry->Ctx);
+    }
+  else if (Entry->Kind == TASK_BATCH)
+    {
+      (*(Sch_BatchTask_t)Entry->Task)(&Entry->Ctx, 1);
+    }
+  else
+    {
+      (*Entry->Task)();
+    }
 }
 
-/**
- * @brief A handler for SIGINT handler to be invoked when user
- * presses CTRL+C
- * @param SIGINT signal number
- * @param si information from the signal sender
- * @param uc the context of signal
+/*********************************************************************
+* Function : Ctx_Batch()
+*//**
+* \b Description:
+* Utility function used to add a due batch task instance to the group of
+* its function, running the group first if it's full. An instance whose
+* function finds no free group runs alone.
+*
+* @param Sch the scheduler instance.
+* @param Entry the due batch task.
+*
+* @return void
+*
+* @see Ctx_RunBatch
+**********************************************************************/
+static void Ctx_Batch(Sch_t *Sch, TaskConfig_t *Entry)
+{
+  BatchGroup_t *Group = NULL;
+  uint32_t Index;
+
+  for (Index = 0; Index < SCH_BATCH_GROUPS && Group == NULL; Index++)
+    {
+      if (Sch->Batches[Index].Task == Entry->Task ||
+          Sch->Batches[Index].Task == NULL)
+        {
+          Group = &Sch->Batches[Index];
+        }
+    }
+  if (Group == NULL)
+    {
+      Ctx_Run(Sch, Entry);
+      Entry->RunMe -= 1;
+      return;
+    }
+
+  if (Group->Count == SCH_BATCH_MAX)
+    {
+      Ctx_RunBatch(Sch, Group);
+    }
+  Group->Task = Entry->Task;
+  Group->Entries[Group->Count++] = Entry;
+  Entry->RunMe -= 1;
+}
+
+/*********************************************************************
+* Function : Ctx_RunBatch()
+*//**
+* \b Description:
+* Utility function used to call a batch task once with the contexts of
+* the instances in its group, then empty the group. With SCH_STATS each
+* instance is accounted an equal share of the call. The instances
+* deleted since they were grouped (NULL entries) are left out.
+*
+* @param Sch the scheduler instance.
+* @param Group the group to run, it may be empty.
+*
+* @return void
+*
+* @see Ctx_Batch
+**********************************************************************/
+static void Ctx_RunBatch(Sch_t *Sch, BatchGroup_t *Group)
+{
+  uint32_t Index, Count = 0;
+#if SCH_STATS
+  uint64_t Start = Sch_NowNs();
+#endif
+#if SCH_SIM
+  const uint64_t HostStart = Sim_HostNs();
+  uint64_t CostNs = 0;
+#endif
+#if SCH_TRACE
+  uint8_t Owner;
+  uint32_t TaskId;
+  uint64_t TraceStart, TraceEnd;
+#endif
+
+  for (Index = 0; Index < Group->Count; Index++)
+    {
+      if (Group->Entries[Index] != NULL)
+        {
+          Group->Entries[Count++] = Group->Entries[Index];
+        }
+    }
+  Group->Count = Count;
+  if (Group->Count == 0)
+    {
+      return;
+    }
+#if SCH_TRACE
+  // The run is traced under the first instance of the group
+  TaskId = Trace_TaskId(Group->Entries[0], &Owner);
+  TraceStart = Trace_Now();
+  Trace_Record(Sch, SCH_TRACE_RUN_START, TaskId, Group->Count, Owner, TraceStart);
+#endif
+  for (Index = 0; Index < Group->Count; Index++)
+    {
+      Sch->BatchCtx[Index] = Group->Entries[Index]->Ctx;
+    }
+  (*(Sch_BatchTask_t)Group->Task)(Sch->BatchCtx, Group->Count);
+  // The call itself may have deleted some of its instances
+#if SCH_SIM
+  // The declared WCETs of the instances, or the measured call if one has none
+  for (Index = 0; Index < Group->Count && CostNs != UINT64_MAX; Index++)
+    {
+      if (Group->Entries[Index] != NULL)
+        {
+          CostNs = Group->Entries[Index]->WcetUs != 0 ?
+            CostNs + (uint64_t)Group->Entries[Index]->WcetUs * 1000u : UINT64_MAX;
+        }
+    }
+  Sim_Charge(CostNs != UINT64_MAX ? CostNs : 0, HostStart);
+#endif
+#if SCH_TRACE
+  TraceEnd = Trace_Now();
+  Trace_Record(Sch, SCH_TRACE_RUN_END, TaskId, Group->Count, Owner, TraceEnd);
+  if (TraceEnd - TraceStart > NS_PER_TICK)
+    {
+      Trace_Record(Sch, SCH_TRACE_OVERRUN, TaskId, Group->Count, Owner, TraceEnd);
+    }
+#endif
+#if SCH_SHM
+  for (Index = 0; Index < Group->Count; Index++)
+    {
+      if (Group->Entries[Index] != NULL)
+        {
+          Group->Entries[Index]->Dispatches++;
+        }
+    }
+#endif
+
+#if SCH_STATS
+  Start = (Sch_NowNs() - Start) / Group->Count;
+  Sch->Stats.Dispatches += Group->Count;
+  for (Index = 0; Index < Group->Count; Index++)
+    {
+      if (Group->Entries[Index] != NULL)
+        {
+          Stats_Record(&Group->Entries[Index]->Stats, Start);
+        }
+    }
+#endif
+  Group->Count = 0;
+}
+
+/*********************************************************************
+* Function : Ctx_Ungroup()
+*//**
+* \b Description:
+* Utility function used to take a deleted batch instance out of the
+* groups of the round: its entry becomes NULL, so the group doesn't
+* call it with the context of a cleared or reused slot.
+*
+* @param Sch the scheduler instance.
+* @param Entry the batch task being deleted.
+*
+* @return void
+*
+* @see Ctx_DeleteTask
+**********************************************************************/
+static void Ctx_Ungroup(Sch_t *Sch, const TaskConfig_t *Entry)
+{
+  BatchGroup_t *Group;
+  uint32_t Index;
+
+  for (Group = Sch->Batches; Group < &Sch->Batches[SCH_BATCH_GROUPS]; Group++)
+    {
+      for (Index = 0; Group->Task == Entry->Task && Index < Group->Count; Index++)
+        {
+          if (Group->Entries[Index] == Entry)
+            {
+              Group->Entries[Index] = NULL;
+            }
+        }
+    }
+}
+
+#if SCH_DISPATCH_BUDGET_US
+/*********************************************************************
+* Function : Ctx_Unbatch()
+*//**
+* \b Description:
+* Utility function used to empty a group without running it when the
+* dispatch budget is spent: each instance gets its run back and stays
+* in the ready mask for the next round. The deleted instances (NULL
+* entries) are skipped.
+*
+* @param Sch the scheduler instance.
+* @param Group the group to drop, it may be empty.
+*
+* @return void
+*
+* @see Ctx_Dispatch
+**********************************************************************/
+static void Ctx_Unbatch(Sch_t *Sch, BatchGroup_t *Group)
+{
+  TaskConfig_t *Entry;
+  uint32_t Index;
+
+  for (Index = 0; Index < Group->Count; Index++)
+    {
+      Entry = Group->Entries[Index];
+      // Deleted since it was grouped, its slot may even be taken again
+      if (Entry == NULL)
+        {
+          continue;
+        }
+      Entry->RunMe += 1;
+      BIT_SET(Sch->Ready[Entry->Priority], (uint32_t)(Entry - Sch->Config));
+#if SCH_SHM
+      Shm_PublishTask(Sch, (uint32_t)(Entry - Sch->Config));
+#endif
+    }
+  Group->Count = 0;
+}
+
+/*********************************************************************
+* Function : Ctx_OverBudget()
+*//**
+* \b Description:
+* Utility function used to check whether a dispatch round started at
+* Start has spent SCH_DISPATCH_BUDGET_US, counting the cut if so.
+*
+* @param Sch the scheduler instance.
+* @param Start the start of the round, Sch_NowNs().
+*
+* @return uint8_t 1 if the budget is spent, else 0.
+*
+* @see Ctx_Dispatch
+**********************************************************************/
+static uint8_t Ctx_OverBudget(Sch_t *Sch, const uint64_t Start)
+{
+  if (Sch_NowNs() - Start < (uint64_t)SCH_DISPATCH_BUDGET_US * 1000u)
+    {
+      return 0;
+    }
+#if SCH_STATS
+  Sch->Stats.BudgetCuts++;
+#else
+  (void)Sch;
+#endif
+  return 1;
+}
+#endif
+/*********************************************************************
+* Function : Ctx_GoToSleep()
+*//**
+* \b Description:
+* Utility function used to make CPU enter sleep mode. It's invoked inside Sch_DispatchTasks
+* In tickless mode it first arms the timer as a one-shot for the tick 
+* the next task is due at.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The CPU enters into sleep mode.
+*
+* @param Sch the scheduler instance.
+*
+* @return void
+*
+* \b Example:
+* @code
+* Sch_Init();
+* Sch_DispatchTasks();
+* @endcode
+*
+* @see Sch_Init
+* @see Sch_DispatchTasks
+*
+**********************************************************************/
+static void Ctx_GoToSleep(Sch_t *Sch)
+{
+#if SCH_CLOCK_DRIVEN
+#if SCH_TICKLESS
+  uint64_t Deadline = Sch->Epoch +
+    (Sch->TickNow + (uint64_t)Ctx_NextDue(Sch)) * NS_PER_TICK;
+#else
+  // The next tick, wherever the previous wakeup landed
+  uint64_t Deadline = Sch->Epoch + (uint64_t)Sch->TickNow * NS_PER_TICK;
+#endif
+#if !SCH_SIM
+  struct itimerspec its;
+
+  its.it_value.tv_sec = Deadline / NS_PER_SEC;
+  its.it_value.tv_nsec = Deadline % NS_PER_SEC;
+  its.it_interval.tv_sec = 0;
+  its.it_interval.tv_nsec = 0;
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
+  if (timerfd_settime(Sch->TimerFd, TFD_TIMER_ABSTIME, &its, NULL) == -1)
+#else
+  if (timer_settime(Sch->Timer, TIMER_ABSTIME, &its, NULL) == -1)
+#endif
+    {
+      perror("timer_settime");
+      exit(EXIT_FAILURE);
+    }
+#endif
+#endif
+
+  TRACE(Sch, SCH_TRACE_SLEEP_ENTER, Sch->TickNow, 0);
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
+  struct epoll_event Events[SCH_MAX_FDS + FD_KEY_APP];
+  int Count;
+
+  /* Application descriptors and steal kicks are served without leaving
+  the loop, only a timer expiration, a signal or Sch_StopCores end it */
+  while (Sch->PendingTicks == 0 && !Ctx_HasPosted(Sch) &&
+         atomic_load_explicit(&Sch->Commands.Tail, memory_order_relaxed) == Sch->Commands.Head &&
+         atomic_load_explicit(&CoresStop, memory_order_relaxed) == 0)
+    {
+      Count = epoll_wait(Sch->EpollFd, Events, SCH_MAX_FDS + FD_KEY_APP, -1);
+      if (Count == -1)
+        {
+          if (errno == EINTR)
+            {
+              break;
+            }
+          perror("epoll_wait");
+          exit(EXIT_FAILURE);
+        }
+      Ctx_HandleEvents(Sch, Events, Count);
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+      Ctx_Steal(Sch);
+#endif
+    }
+#elif SCH_SIM
+  Sim_Sleep(Sch, Deadline);
+#elif SCH_CLOCK_DRIVEN
+  sigsuspend(&SleepMask);
+#else
+  /* Only the timer is a tick: a steal kick or a dump request is served,
+  then the thread sleeps again, so the schedule doesn't shift */
+  while (!TimerFired)
+    {
+      pause();
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+      Ctx_Steal(Sch);
+#endif
+#if SCH_TRACE && SCH_TRACE_SIGNAL
+      Trace_DumpRequested(Sch);
+#endif
+    }
+  TimerFired = 0;
+#endif
+  Sch->IdleStats.Wakeups++;
+  TRACE(Sch, SCH_TRACE_SLEEP_EXIT, Sch->TickNow, 0);
+}
+
+/*********************************************************************
+* Function : Sch_AddTask()
+*//**
+* \b Description:
+*
+* This function is used to add task to the scheduler. A one-shot task
+* (Period 0) runs once, Delay ticks from now, then its slot is freed and
+* its id may be handed out again. SCH_ENGINE_TABLE has no one-shot tasks.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The task will be added to the scheduler.
+*
+* @param Function a function pointer to the task function.
+* @param Delay a delay before the function executed for its first time
+* @param Period the period of the task, 0 for a one-shot task
+*
+* @return Sch_TaskId_t the id of the task, or SCH_NO_TASK if the task
+* table is full.
+*
+* \b Example:
+* @code
+* Sch_Init();
+* Sch_AddTask(count, 0, 10); // Make a task starting at 0 tick with period 10 ticks. 
+* Sch_AddTask(retry, 50, 0); // Run retry once, 50 ticks from now.
+* @endcode
+*
+* @see Sch_Init
+*
+**********************************************************************/
+Sch_TaskId_t Sch_AddTask(void (*Function)(),
+      const Sch_Tick_t Delay,
+      const Sch_Tick_t Period)
+{
+  return Id_Make(&Instances[0],
+                 Ctx_AddTask(&Instances[0], Function, Delay, Period, SCH_MISS_DEFER, 0));
+}
+
+/*********************************************************************
+* Function : Sch_AddTaskWithPolicy()
+*//**
+* \b Description:
+*
+* This function is used to add a task to the scheduler, with the policy
+* applied to its releases that come while a previous run is still
+* pending (an overrunning task, a late wakeup...). Sch_AddTask uses
+* SCH_MISS_DEFER.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The task will be added to the scheduler.
+*
+* @param Function a function pointer to the task function.
+* @param Delay a delay before the function executed for its first time
+* @param Period the period of the task, 0 for a one-shot task
+* @param Policy SCH_MISS_CATCH_UP to run every missed release back to
+* back, SCH_MISS_SKIP to keep at most one pending run, SCH_MISS_DEFER
+* to run one per dispatch.
+*
+* @return Sch_TaskId_t the id of the task, or SCH_NO_TASK if the task
+* table is full.
+*
+* \b Example:
+* @code
+* Sch_Init();
+* // Only the latest sample matters, don't read the sensor 5 times in a row
+* Sch_AddTaskWithPolicy(readSensor, 0, 10, SCH_MISS_SKIP);
+* @endcode
+*
+* @see Sch_GetMissedReleases
+*
+**********************************************************************/
+Sch_TaskId_t Sch_AddTaskWithPolicy(void (*Function)(void),
+      const Sch_Tick_t Delay,
+      const Sch_Tick_t Period,
+      const Sch_MissPolicy_t Policy)
+{
+  return Id_Make(&Instances[0],
+                 Ctx_AddTask(&Instances[0], Function, Delay, Period, Policy, 0));
+}
+
+/*********************************************************************
+* Function : Sch_AddEventTask()
+*//**
+* \b Description:
+*
+* This function is used to add a task that the clock never releases:
+* it runs in the dispatch round that follows a Sch_PostEvent for it,
+* instead of polling its input from a periodic task. The task stays
+* until it's deleted.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The task will be added to the scheduler.
+*
+* @param Function a function pointer to the task function.
+*
+* @return Sch_TaskId_t the id of the task, or SCH_NO_TASK if the task
+* table is full (or, with SCH_ENGINE_TABLE, the next free id is a table
+* one: add the event tasks after the table tasks).
+*
+* \b Example:
+* @code
+* Sch_Init();
+* RxTask = Sch_AddEventTask(handleRx);
+* @endcode
+*
+* @see Sch_PostEvent
+*
+**********************************************************************/
+Sch_TaskId_t Sch_AddEventTask(void (*Function)(void))
+{
+  return Id_Make(&Instances[0], Ctx_AddTask(&Instances[0], Function, 0, 0, SCH_MISS_DEFER, 1));
+}
+
+/*********************************************************************
+* Function : Sch_PostEvent()
+*//**
+* \b Description:
+*
+* This function is used to release a task once, from any context: a
+* signal handler, another thread or the scheduler thread itself. It's
+* lock-free and async-signal-safe. The task runs in the next dispatch
+* round, the posts that come before that round are merged into one
+* release. Any task can be posted, event tasks are only released this
+* way. With SCH_BACKEND_TIMERFD or a clock driven SCH_BACKEND_SIGNAL
+* the scheduler thread is woken up right away, with the periodic
+* SCH_BACKEND_SIGNAL timer the post waits for the next tick.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The task is released by the next dispatch round.
+*
+* @param TaskId the id returned by Sch_AddEventTask or Sch_AddTask.
+*
+* @return int 0, or -1 for an invalid id.
+*
+* \b Example:
+* @code
+* static void onSigio(int Sig)
+* {
+*   Sch_PostEvent(RxTask);
+* }
+* @endcode
+*
+* @see Sch_AddEventTask
+*
+**********************************************************************/
+int Sch_PostEvent(const Sch_TaskId_t TaskId)
+{
+  Sch_t *Sch = &Instances[0];
+  const uint32_t Slot = Id_Slot(Sch, TaskId);
+
+  if (Slot >= SCH_MAX_TASKS)
+    {
+      return -1;
+    }
+  atomic_fetch_or_explicit(&Sch->Posted[Slot / 64u], (uint64_t)1 << (Slot % 64u),
+                           memory_order_release);
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD || SCH_CLOCK_DRIVEN
+  // Any other signal would count as a tick of the periodic signal timer
+  if (Sch->HasTimer)
+    {
+      Ctx_Wake(Sch);
+    }
+#endif
+  return 0;
+}
+
+/*********************************************************************
+* Function : Sch_SetTaskPriority()
+*//**
+* \b Description:
+*
+* This function is used to set the dispatch priority of a task. Every
+* dispatch round runs the due tasks from priority 0 down, in slot order
+* within a priority. With SCH_DISPATCH_BUDGET_US the tasks below
+* priority 0 that would start after the budget is spent wait for the
+* next round. Tasks are added with the lowest priority,
+* SCH_PRIORITIES - 1.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The task is dispatched at its new priority, its
+* pending runs included.
+*
+* @param TaskId the task.
+* @param Priority the priority, < SCH_PRIORITIES, 0 is the highest.
+*
+* @return int 0, or -1 if there's no such task or priority.
+*
+* \b Example:
+* @code
+* Sch_TaskId_t Brake = Sch_AddTask(brakeControl, 0, 1);
+* Sch_SetTaskPriority(Brake, 0);
+* @endcode
+*
+* @see Sch_AddTask
+*
+**********************************************************************/
+int Sch_SetTaskPriority(const Sch_TaskId_t TaskId, const uint8_t Priority)
+{
+  Sch_t *Sch = &Instances[0];
+  const uint32_t Slot = Id_Slot(Sch, TaskId);
+  TaskConfig_t *Entry;
+
+  if (Slot >= SCH_MAX_TASKS || Sch->Config[Slot].Task == NULL ||
+      Priority >= SCH_PRIORITIES)
+    {
+      return -1;
+    }
+  Entry = &Sch->Config[Slot];
+  if (Entry->RunMe > 0)
+    {
+      BIT_CLEAR(Sch->Ready[Entry->Priority], Slot);
+      BIT_SET(Sch->Ready[Priority], Slot);
+    }
+  Entry->Priority = Priority;
+  return 0;
+}
+
+/*********************************************************************
+* Function : Sch_SetTaskWcet()
+*//**
+* \b Description:
+*
+* This function is used to declare the worst case run time of a task.
+* Sch_Rebalance and Sch_GetPeakLoad count it in the load of the tick the
+* task is released at, and with SCH_BACKEND_SIM every run of the task
+* advances the virtual clock by it instead of by the host run time.
+* Sch_AddTaskAuto sets it already.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The task is accounted WcetUs per run.
+*
+* @param TaskId the task.
+* @param WcetUs the worst case run time in us, 0 for unknown.
+*
+* @return int 0, or -1 if there's no such task.
+*
+* \b Example:
+* @code
+* Sch_TaskId_t Filter = Sch_AddTask(filterSamples, 0, 2);
+* Sch_SetTaskWcet(Filter, 800);
+* @endcode
+*
+* @see Sch_AddTaskAuto
+* @see Sch_SimRun
+*
+**********************************************************************/
+int Sch_SetTaskWcet(const Sch_TaskId_t TaskId, const uint32_t WcetUs)
+{
+  Sch_t *Sch = &Instances[0];
+  const uint32_t Slot = Id_Slot(Sch, TaskId);
+
+  if (Slot >= SCH_MAX_TASKS || Sch->Config[Slot].Task == NULL)
+    {
+      return -1;
+    }
+  Sch->Config[Slot].WcetUs = WcetUs;
+  return 0;
+}
+
+/*********************************************************************
+* Function : Sch_AddTaskCtx()
+*//**
+* \b Description:
+*
+* This function is used to add a task that takes an argument: Function
+* is called with Ctx at every run, so one task body can serve many
+* instances, each with its own state instead of function-local statics.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* PRE-CONDITION: Ctx stays valid until the task is deleted <br>
+* POST-CONDITION: The task will be added to the scheduler.
+*
+* @param Function a function pointer to the task function.
+* @param Ctx the argument of Function, it may be NULL.
+* @param Delay a delay before the function executed for its first time
+* @param Period the period of the task, 0 for a one-shot task
+*
+* @return Sch_TaskId_t the id of the task, or SCH_NO_TASK if the task
+* table is full.
+*
+* \b Example:
+* @code
+* Sch_Arena_t Arena;
+* static uint8_t Buffer[1000 * sizeof(Filter_t)];
+*
+* Sch_Init();
+* Sch_ArenaInit(&Arena, Buffer, sizeof(Buffer));
+* for (Index = 0; Index < 1000; Index++)
+*   {
+*     Filter_t *Filter = Sch_ArenaAlloc(&Arena, sizeof(Filter_t));
+*     Filter->Channel = Index;
+*     Sch_AddTaskCtx(Filter_Step, Filter, Index % 10, 10);
+*   }
+* @endcode
+*
+* @see Sch_ArenaAlloc
+*
+**********************************************************************/
+Sch_TaskId_t Sch_AddTaskCtx(void (*Function)(void *Ctx),
+      void *Ctx,
+      const Sch_Tick_t Delay,
+      const Sch_Tick_t Period)
+{
+  Sch_t *Sch = &Instances[0];
+  Sch_TaskId_t TaskId;
+
+  TaskId = Ctx_AddTask(Sch, (void (*)(void))Function, Delay, Period, SCH_MISS_DEFER, 0);
+  if (TaskId != SCH_NO_TASK)
+    {
+      Sch->Config[TaskId].Ctx = Ctx;
+      Sch->Config[TaskId].Kind = TASK_CTX;
+    }
+  return Id_Make(Sch, TaskId);
+}
+
+/*********************************************************************
+* Function : Sch_AddTaskBatch()
+*//**
+* \b Description:
+*
+* This function is used to add one instance of a batch task. The due
+* instances of the same function are grouped by each dispatch round and
+* the function is called once per group of up to SCH_BATCH_MAX with
+* their contexts, e.g. to filter many channels at a time with SIMD.
+* The groups run after the other due tasks of their priority level; every
+* instance runs at most once per round (SCH_MISS_DEFER).
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* PRE-CONDITION: Ctx stays valid until the task is deleted <br>
+* POST-CONDITION: The task will be added to the scheduler.
+*
+* @param Function the batch function shared by the instances.
+* @param Ctx the context of this instance, it may be NULL.
+* @param Delay a delay before the function executed for its first time
+* @param Period the period of the task, it must be > 0
+*
+* @return Sch_TaskId_t the id of the task, or SCH_NO_TASK if the task
+* table is full or the period is 0.
+*
+* \b Example:
+* @code
+* static void Filter_Step(void **Ctx, uint32_t Count)
+* {
+*   // Count <= SCH_BATCH_MAX channels at a time
+* }
+*
+* for (Index = 0; Index < 64; Index++)
+*   {
+*     Sch_AddTaskBatch(Filter_Step, &Channels[Index], 0, 1);
+*   }
+* @endcode
+*
+* @see Sch_AddTaskCtx
+*
+**********************************************************************/
+Sch_TaskId_t Sch_AddTaskBatch(Sch_BatchTask_t Function,
+      void *Ctx,
+      const Sch_Tick_t Delay,
+      const Sch_Tick_t Period)
+{
+  Sch_t *Sch = &Instances[0];
+  Sch_TaskId_t TaskId;
+
+  // A group may still hold the instance after its run, it can't free its slot
+  if (Period == 0)
+    {
+      return SCH_NO_TASK;
+    }
+  TaskId = Ctx_AddTask(Sch, (void (*)(void))Function, Delay, Period, SCH_MISS_DEFER, 0);
+  if (TaskId != SCH_NO_TASK)
+    {
+      Sch->Config[TaskId].Ctx = Ctx;
+      Sch->Config[TaskId].Kind = TASK_BATCH;
+    }
+  return Id_Make(Sch, TaskId);
+}
+
+/*********************************************************************
+* Function : Sch_ArenaInit()
+*//**
+* \b Description:
+*
+* This function is used to hand a buffer to an arena, for the contexts
+* of Sch_AddTaskCtx tasks. Calling it again on the same buffer frees
+* everything the arena gave.
+*
+* PRE-CONDITION: Buffer holds Size bytes <br>
+* POST-CONDITION: The arena is empty.
+*
+* @param Arena the arena.
+* @param Buffer the memory the arena allocates from.
+* @param Size the buffer size in bytes.
+*
+* @return void
+*
+* @see Sch_ArenaAlloc
+*
+**********************************************************************/
+void Sch_ArenaInit(Sch_Arena_t *Arena, void *Buffer, const size_t Size)
+{
+  Arena->Base = Buffer;
+  Arena->Size = Size;
+  Arena->Used = 0;
+}
+
+/*********************************************************************
+* Function : Sch_ArenaAlloc()
+*//**
+* \b Description:
+*
+* This function is used to take the next Size bytes of an arena, aligned
+* for any type. Consecutive allocations are contiguous apart from the
+* alignment padding, so the contexts of tasks added one after the other
+* share cache lines.
+*
+* PRE-CONDITION: Sch_ArenaInit() is called <br>
+* POST-CONDITION: The memory is owned by the caller until the arena is
+* initialized again.
+*
+* @param Arena the arena.
+* @param Size the bytes to allocate.
+*
+* @return void* the memory, or NULL if the arena is exhausted.
+*
+* @see Sch_AddTaskCtx
+*
+**********************************************************************/
+void *Sch_ArenaAlloc(Sch_Arena_t *Arena, const size_t Size)
+{
+  const size_t Align = _Alignof(max_align_t);
+  uintptr_t Address = (uintptr_t)Arena->Base + Arena->Used;
+  size_t Padding = (Align - Address % Align) % Align;
+
+  if (Arena->Used + Padding > Arena->Size ||
+      Size > Arena->Size - Arena->Used - Padding)
+    {
+      return NULL;
+    }
+  Arena->Used += Padding + Size;
+  return (void *)(Address + Padding);
+}
+
+/*********************************************************************
+* Function : Sch_AddTaskOnCore()
+*//**
+* \b Description:
+*
+* This function is used to add a task to the scheduler instance of
+* a core. The task will only ever run on the worker thread of that core.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* PRE-CONDITION: Sch_StartCores() isn't called yet <br>
+* POST-CONDITION: The task will be added to the scheduler of the core.
+*
+* @param Core the core index, < SCH_MAX_CORES
+* @param Function a function pointer to the task function.
+* @param Delay a delay before the function executed for its first time
+* @param Period the period of the task, 0 for a one-shot task
+*
+* @return Sch_TaskId_t the id of the task in the core table, or
+* SCH_NO_TASK if the core doesn't exist or its table is full.
+*
+* \b Example:
+* @code
+* Sch_Init();
+* Sch_AddTaskOnCore(1, count, 0, 10); // count runs on core 1
+* Sch_StartCores(2);
+* @endcode
+*
+* @see Sch_StartCores
+*
+**********************************************************************/
+Sch_TaskId_t Sch_AddTaskOnCore(const uint32_t Core,
+      void (*Function)(void),
+      const Sch_Tick_t Delay,
+      const Sch_Tick_t Period)
+{
+  if (Core >= SCH_MAX_CORES)
+    {
+      return SCH_NO_TASK;
+    }
+  return Id_Make(&Instances[Core],
+                 Ctx_AddTask(&Instances[Core], Function, Delay, Period, SCH_MISS_DEFER, 0));
+}
+
+/*********************************************************************
+* Function : Ctx_AddTask()
+*//**
+* \b Description:
+* Utility function used to add a task to one instance.
+*
+* @param Sch the scheduler instance.
+* @param Function a function pointer to the task function.
+* @param Delay a delay before the function executed for its first time
+* @param Period the period of the task, 0 for a one-shot task
+* @param Policy what happens to its releases that come too late
+* @param Event 1 for a task released by Sch_PostEvent only, Delay and
+* Period are then ignored.
+*
+* @return Sch_TaskId_t the id of the task, or SCH_NO_TASK.
+*
+* @see Sch_AddTask
+**********************************************************************/
+static Sch_TaskId_t Ctx_AddTask(Sch_t *Sch, void (*Function)(void),
+      const Sch_Tick_t Delay,
+      const Sch_Tick_t Period,
+      const Sch_MissPolicy_t Policy,
+      const uint8_t Event)
+{
+  uint32_t TaskId = Free_Take(Sch, Delay, Period, Event);
+
+  if (TaskId == FREE_NIL)
+    {
+      // The task table is full, or no free slot fits the schedule table
+      return SCH_NO_TASK;
+    }
+  Ctx_StartTask(Sch, TaskId, Function, Delay, Period, Policy, Event);
+  return TaskId;
+}
+
+/*********************************************************************
+* Function : Ctx_StartTask()
+*//**
+* \b Description:
+* Utility function used to fill a slot taken from the free list and
+* hand the task to the engine.
+*
+* @param Sch the scheduler instance.
+* @param TaskId the slot, popped from the free list.
+* @param Function a function pointer to the task function.
+* @param Delay a delay before the function executed for its first time
+* @param Period the period of the task, 0 for a one-shot task
+* @param Policy what happens to its releases that come too late
+* @param Event 1 for a task released by Sch_PostEvent only.
+*
+* @return void
+*
+* @see Ctx_AddTask
+**********************************************************************/
+static void Ctx_StartTask(Sch_t *Sch, const uint32_t TaskId,
+      void (*Function)(void),
+      const Sch_Tick_t Delay,
+      const Sch_Tick_t Period,
+      const Sch_MissPolicy_t Policy,
+      const uint8_t Event)
+{
+  TaskConfig_t *Config = Sch->Config;
+
+  BIT_SET(Sch->Live, TaskId);
+  Config[TaskId].Task = Function;
+  if (!Event)
+    {
+      BIT_SET(Sch->Timed, TaskId);
+      TASK_DELAY(Sch, TaskId) = Delay;
+    }
+  Config[TaskId].Period = Event ? 0 : Period;
+  Config[TaskId].Event = Event;
+  Config[TaskId].RunMe = 0;
+  Config[TaskId].Policy = Policy;
+  Config[TaskId].Missed = 0;
+  Config[TaskId].WcetUs = 0;
+  Config[TaskId].AutoDelay = 0;
+  Config[TaskId].Ctx = NULL;
+  Config[TaskId].Kind = TASK_PLAIN;
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+  Config[TaskId].Pinned = 0;
+#endif
+#if SCH_STATS
+  Config[TaskId].Stats = (Sch_TaskStats_t){ .MinNs = UINT64_MAX };
+#endif
+#if SCH_SHM
+  Config[TaskId].Releases = 0;
+  Config[TaskId].Dispatches = 0;
+#endif
+
+#if SCH_ENGINE == SCH_ENGINE_WHEEL
+  if (!Event)
+    {
+      Config[TaskId].Expiry = Sch->TickNow + TASK_DELAY(Sch, TaskId);
+      Wheel_Insert(Sch, TaskId);
+    }
+#endif
+#if SCH_SHM
+  Shm_PublishTask(Sch, TaskId);
+#endif
+}
+
+/*********************************************************************
+* Function : Sch_DeleteTask()
+*//**
+* \b Description:
+*
+* This function is used to delete a task from the scheduler. In the
+* work-stealing mode a task with stolen instances still running stops
+* being released at once, its slot is freed at a later tick boundary.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The task will be deleted.
+*
+* @param TaskId The id of the task to be deleted, SCH_NO_TASK is ignored.
+*
+* @return void
+*
+* \b Example:
+* @code
+* Sch_Init();
+* Sch_TaskId_t taskId = Sch_AddTask(count, 0, 10); 
+* Sch_DeleteTask(taskId);
+* @endcode
+*
+* @see Sch_Init
+* @see Sch_AddTask
+*
+**********************************************************************/
+void Sch_DeleteTask(const Sch_TaskId_t TaskId)
+{
+  Ctx_DeleteTask(&Instances[0], Id_Slot(&Instances[0], TaskId));
+}
+
+/*********************************************************************
+* Function : Sch_DeleteTaskOnCore()
+*//**
+* \b Description:
+*
+* This function is used to delete a task from the scheduler instance
+* of a core.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* PRE-CONDITION: The worker threads aren't running <br>
+* POST-CONDITION: The task will be deleted.
+*
+* @param Core the core index the task was added on.
+* @param TaskId The id returned by Sch_AddTaskOnCore.
+*
+* @return void
+*
+* @see Sch_AddTaskOnCore
+*
+**********************************************************************/
+void Sch_DeleteTaskOnCore(const uint32_t Core, const Sch_TaskId_t TaskId)
+{
+  if (Core < SCH_MAX_CORES)
+    {
+      Ctx_DeleteTask(&Instances[Core], Id_Slot(&Instances[Core], TaskId));
+    }
+}
+
+/*********************************************************************
+* Function : Ctx_DeleteTask()
+*//**
+* \b Description:
+* Utility function used to delete a task from one instance.
+*
+* @param Sch the scheduler instance.
+* @param TaskId The id of the task to be deleted, SCH_NO_TASK is ignored.
+*
+* @return void
+*
+* @see Sch_DeleteTask
+**********************************************************************/
+static void Ctx_DeleteTask(Sch_t *Sch, const Sch_TaskId_t TaskId)
+{
+  if (TaskId >= SCH_MAX_TASKS || Sch->Config[TaskId].Task == NULL)
+    {
+      return;
+    }
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+  if (BIT_TEST(Sch->Doomed, TaskId))
+    {
+      return;
+    }
+#endif
+#if SCH_ENGINE == SCH_ENGINE_WHEEL
+  // Event tasks and fired one-shot tasks aren't in the wheel
+  if (BIT_TEST(Sch->Timed, TaskId))
+    {
+      Wheel_Remove(Sch, TaskId);
+    }
+#endif
+  if (Sch->Config[TaskId].Kind == TASK_BATCH)
+    {
+      Ctx_Ungroup(Sch, &Sch->Config[TaskId]);
+    }
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+  // A thief still runs a stolen instance with the entry: the task stops
+  // being released now, Ctx_Reap clears and frees the slot once it's back
+  if (atomic_load_explicit(&Sch->Config[TaskId].InFlight, memory_order_acquire) != 0)
+    {
+      BIT_CLEAR(Sch->Live, TaskId);
+      BIT_CLEAR(Sch->Timed, TaskId);
+      BIT_CLEAR(Sch->Ready[Sch->Config[TaskId].Priority], TaskId);
+      Sch->Config[TaskId].RunMe = 0;
+      BIT_SET(Sch->Doomed, TaskId);
+      return;
+    }
+#endif
+  Ctx_ClearTask(Sch, TaskId);
+  Free_Push(Sch, TaskId);
+}
+
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+/*********************************************************************
+* Function : Ctx_Reap()
+*//**
+* \b Description:
+* Utility function used to clear and free the slots of the deleted
+* tasks once no stolen instance of theirs is running any more.
+*
+* @param Sch the scheduler instance.
+*
+* @return void
+*
+* @see Ctx_DeleteTask
+**********************************************************************/
+static void Ctx_Reap(Sch_t *Sch)
+{
+  uint32_t TaskId, Word;
+  uint64_t Bits;
+
+  for (Word = 0; Word < LIVE_WORDS; Word++)
+    {
+      for (Bits = Sch->Doomed[Word]; Bits != 0; Bits &= Bits - 1)
+        {
+          TaskId = Word * 64u + (uint32_t)__builtin_ctzll(Bits);
+          if (atomic_load_explicit(&Sch->Config[TaskId].InFlight, memory_order_acquire) == 0)
+            {
+              Ctx_ClearTask(Sch, TaskId);
+              Free_Push(Sch, TaskId);
+            }
+        }
+    }
+}
+#endif
+
+/*********************************************************************
+* Function : Free_Pop()
+*//**
+* \b Description:
+* Utility function used to take the first free slot. Any thread may
+* call it, the tag of the top makes a slot freed and taken again in
+* between fail the CAS (ABA).
+*
+* @param Sch the scheduler instance.
+*
+* @return uint32_t the slot, or FREE_NIL if the table is full.
+*
+* @see Free_Push
+**********************************************************************/
+static uint32_t Free_Pop(Sch_t *Sch)
+{
+  uint64_t Top = atomic_load_explicit(&Sch->FreeTop, memory_order_acquire);
+  uint64_t Next;
+
+  do
+    {
+      if ((uint32_t)Top == FREE_NIL)
+        {
+          return FREE_NIL;
+        }
+      Next = FREE_TOP((Top >> 32) + 1,
+                      __atomic_load_n(&Sch->Config[(uint32_t)Top].NextFree, __ATOMIC_RELAXED));
+    }
+  while (!atomic_compare_exchange_weak_explicit(&Sch->FreeTop, &Top, Next,
+                                                memory_order_acquire, memory_order_acquire));
+  return (uint32_t)Top;
+}
+
+/*********************************************************************
+* Function : Free_Push()
+*//**
+* \b Description:
+* Utility function used to give a slot back, it's handed out next. The
+* slot gets a new generation, so the ids of its last task are stale.
+* With SCH_ENGINE_TABLE a schedule table slot is only marked free, it's
+* taken again by its delay and period (see Free_Take).
+*
+* @param Sch the scheduler instance.
+* @param TaskId the free slot.
+*
+* @return void
+*
+* @see Free_Pop
+**********************************************************************/
+static void Free_Push(Sch_t *Sch, const uint32_t TaskId)
+{
+  uint64_t Top = atomic_load_explicit(&Sch->FreeTop, memory_order_relaxed);
+
+  __atomic_store_n(&Sch->Config[TaskId].Gen,
+                   (Sch_TaskId_t)(__atomic_load_n(&Sch->Config[TaskId].Gen, __ATOMIC_RELAXED) + 1u),
+                   __ATOMIC_RELAXED);
+#if SCH_ENGINE == SCH_ENGINE_TABLE
+  if (TaskId < SCH_TABLE_TASKS)
+    {
+      atomic_fetch_or_explicit(&Sch->TableFree[TaskId / 64u], (uint64_t)1 << (TaskId % 64u),
+                               memory_order_release);
+      return;
+    }
+#endif
+  do
+    {
+      __atomic_store_n(&Sch->Config[TaskId].NextFree, (Sch_TaskId_t)Top, __ATOMIC_RELAXED);
+    }
+  while (!atomic_compare_exchange_weak_explicit(&Sch->FreeTop, &Top,
+                                                FREE_TOP((Top >> 32) + 1, TaskId),
+                                                memory_order_release, memory_order_relaxed));
+}
+
+/*********************************************************************
+* Function : Free_Take()
+*//**
+* \b Description:
+* Utility function used to take a free slot for a new task. With
+* SCH_ENGINE_TABLE the schedule table was generated for the id, delay
+* and period of its tasks: a periodic or one-shot task takes the first
+* free table slot with its delay and period, whatever order the tasks
+* were deleted and added back in. An event task takes a slot from the
+* free list, which only holds the slots after the table ones.
+*
+* @param Sch the scheduler instance.
+* @param Delay the delay of the task.
+* @param Period the period of the task.
+* @param Event 1 for an event task.
+*
+* @return uint32_t the slot, or FREE_NIL if none fits.
+*
+* @see Free_Pop
+**********************************************************************/
+static uint32_t Free_Take(Sch_t *Sch, const Sch_Tick_t Delay,
+      const Sch_Tick_t Period, const uint8_t Event)
+{
+#if SCH_ENGINE == SCH_ENGINE_TABLE
+  Sch_Tick_t TableDelay, TablePeriod;
+  uint32_t TaskId;
+  uint64_t Bit;
+
+  if (Event)
+    {
+      return Free_Pop(Sch);
+    }
+  for (TaskId = 0; TaskId < SCH_TABLE_TASKS; TaskId++)
+    {
+      SCH_TABLE_READ(TableDelay, SchTableDelay[TaskId]);
+      SCH_TABLE_READ(TablePeriod, SchTablePeriod[TaskId]);
+      Bit = (uint64_t)1 << (TaskId % 64u);
+      // Another thread may want the same slot, the one that clears the bit owns it
+      if (Delay == TableDelay && Period == TablePeriod &&
+          (atomic_fetch_and_explicit(&Sch->TableFree[TaskId / 64u], ~Bit, memory_order_acquire) & Bit) != 0)
+        {
+          return TaskId;
+        }
+    }
+  return FREE_NIL;
+#else
+  (void)Delay;
+  (void)Period;
+  (void)Event;
+  return Free_Pop(Sch);
+#endif
+}
+
+/*********************************************************************
+* Function : Id_Make()
+*//**
+* \b Description:
+* Utility function used to make the id of the task in a slot: the slot
+* and, in the bits of Sch_TaskId_t above it, the generation of the slot.
+* A one-shot task frees its slot by itself, so an id kept after its task
+* is gone must not name the next task in the slot.
+*
+* @param Sch the scheduler instance.
+* @param TaskId the slot, SCH_NO_TASK is passed through.
+*
+* @return Sch_TaskId_t the id.
+*
+* @see Id_Slot
+**********************************************************************/
+static Sch_TaskId_t Id_Make(Sch_t *Sch, const uint32_t TaskId)
+{
+  if (TaskId >= SCH_MAX_TASKS)
+    {
+      return SCH_NO_TASK;
+    }
+  return (Sch_TaskId_t)(TaskId |
+    ((uint64_t)__atomic_load_n(&Sch->Config[TaskId].Gen, __ATOMIC_RELAXED) << ID_SLOT_BITS));
+}
+
+/*********************************************************************
+* Function : Id_Slot()
+*//**
+* \b Description:
+* Utility function used to find the slot of a task id.
+*
+* @param Sch the scheduler instance.
+* @param TaskId the id returned when the task was added.
+*
+* @return uint32_t the slot, or SCH_MAX_TASKS if the id is invalid or
+* of a task that was deleted since.
+*
+* @see Id_Make
+**********************************************************************/
+static uint32_t Id_Slot(Sch_t *Sch, const Sch_TaskId_t TaskId)
+{
+  const uint32_t Slot = TaskId & ID_SLOT_MASK;
+
+  if (Slot >= SCH_MAX_TASKS || Id_Make(Sch, Slot) != TaskId)
+    {
+      return SCH_MAX_TASKS;
+    }
+  return Slot;
+}
+
+/*********************************************************************
+* Function : Sch_PostAddTask()
+*//**
+* \b Description:
+*
+* This function is used to add a task from another thread while the
+* scheduler runs. The slot is reserved right away and the task starts at
+* the next tick boundary of the scheduler thread, its Delay counted from
+* there. It never blocks: it's a CAS on the free list and one on the
+* command queue, and it fails rather than waits when either is full.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The task is added before the next tick.
+*
+* @param Function a function pointer to the task function.
+* @param Delay a delay before the function executed for its first time
+* @param Period the period of the task, 0 for a one-shot task
+*
+* @return Sch_TaskId_t the id of the task, or SCH_NO_TASK if the task
+* table or the command queue (SCH_CMD_QUEUE_SIZE) is full.
+*
+* \b Example:
+* @code
+* // From a control-plane thread
+* Job = Sch_PostAddTask(pollDevice, 0, 10);
+* ...
+* Sch_PostDeleteTask(Job);
+* @endcode
+*
+* @see Sch_PostDeleteTask
+*
+**********************************************************************/
+Sch_TaskId_t Sch_PostAddTask(void (*Function)(void),
+      const Sch_Tick_t Delay,
+      const Sch_Tick_t Period)
+{
+  Sch_t *Sch = &Instances[0];
+  uint32_t TaskId = Free_Take(Sch, Delay, Period, 0);
+
+  if (TaskId == FREE_NIL)
+    {
+      return SCH_NO_TASK;
+    }
+  if (Cmd_Post(Sch, CMD_ADD, TaskId, Function, Delay, Period) != 0)
+    {
+      Free_Push(Sch, TaskId);
+      return SCH_NO_TASK;
+    }
+  // The slot is ours until the command is applied, its generation is set
+  return Id_Make(Sch, TaskId);
+}
+
+/*********************************************************************
+* Function : Sch_PostDeleteTask()
+*//**
+* \b Description:
+*
+* This function is used to delete a task from another thread while the
+* scheduler runs. The task is deleted at the next tick boundary of the
+* scheduler thread, after any change posted before. If the task is gone
+* by then (a one-shot task that ran) the id is stale and it's ignored,
+* even if its slot holds a new task.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The task is deleted before the next tick.
+*
+* @param TaskId The id of the task to be deleted.
+*
+* @return int 0, or -1 for an invalid id or a full command queue.
+*
+* @see Sch_PostAddTask
+*
+**********************************************************************/
+int Sch_PostDeleteTask(const Sch_TaskId_t TaskId)
+{
+  if ((TaskId & ID_SLOT_MASK) >= SCH_MAX_TASKS)
+    {
+      return -1;
+    }
+  // The generation is checked when the command is applied
+  return Cmd_Post(&Instances[0], CMD_DELETE, TaskId, NULL, 0, 0);
+}
+
+/*********************************************************************
+* Function : Cmd_Post()
+*//**
+* \b Description:
+* Utility function used to queue a command from any thread. The cell at
+* Tail is free when its Seq equals Tail; producers race for it with a
+* CAS and publish it by bumping its Seq.
+*
+* @param Sch the scheduler instance.
+* @param Kind the command.
+* @param TaskId its task.
+* @param Function, Delay, Period the task of a CMD_ADD.
+*
+* @return int 0, or -1 if the queue is full.
+*
+* @see Ctx_ApplyCommands
+**********************************************************************/
+static int Cmd_Post(Sch_t *Sch, const CmdKind_t Kind, const uint32_t TaskId,
+      void (*Function)(void), const Sch_Tick_t Delay, const Sch_Tick_t Period)
+{
+  CmdQueue_t *Queue = &Sch->Commands;
+  uint32_t Tail = atomic_load_explicit(&Queue->Tail, memory_order_relaxed);
+  CmdCell_t *Cell;
+  int32_t Lag;
+
+  for (;;)
+    {
+      Cell = &Queue->Cells[Tail & CMD_MASK];
+      Lag = (int32_t)(atomic_load_explicit(&Cell->Seq, memory_order_acquire) - Tail);
+      if (Lag == 0)
+        {
+          if (atomic_compare_exchange_weak_explicit(&Queue->Tail, &Tail, Tail + 1,
+                                                    memory_order_relaxed, memory_order_relaxed))
+            {
+              break;
+            }
+        }
+      else if (Lag < 0)
+        {
+          // The instance thread hasn't applied the cell a lap ago yet
+          return -1;
+        }
+      else
+        {
+          Tail = atomic_load_explicit(&Queue->Tail, memory_order_relaxed);
+        }
+    }
+  Cell->Kind = Kind;
+  Cell->TaskId = TaskId;
+  Cell->Task = Function;
+  Cell->Delay = Delay;
+  Cell->Period = Period;
+  atomic_store_explicit(&Cell->Seq, Tail + 1, memory_order_release);
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD || SCH_CLOCK_DRIVEN
+  // A tickless sleep may last longer than a tick
+  if (Sch->HasTimer)
+    {
+      Ctx_Wake(Sch);
+    }
+#endif
+  return 0;
+}
+
+/*********************************************************************
+* Function : Ctx_ApplyCommands()
+*//**
+* \b Description:
+* Utility function used to apply the posted table changes, in order, at
+* a tick boundary of the instance thread. An empty queue costs one load.
+* In the work-stealing mode the slots of the deleted tasks whose stolen
+* runs are over are freed first.
+*
+* @param Sch the scheduler instance.
+*
+* @return void
+*
+* @see Sch_PostAddTask
+**********************************************************************/
+static void Ctx_ApplyCommands(Sch_t *Sch)
+{
+  CmdQueue_t *Queue = &Sch->Commands;
+  CmdCell_t *Cell = &Queue->Cells[Queue->Head & CMD_MASK];
+
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+  Ctx_Reap(Sch);
+#endif
+  while (atomic_load_explicit(&Cell->Seq, memory_order_acquire) == Queue->Head + 1)
+    {
+      if (Cell->Kind == CMD_ADD)
+        {
+          Ctx_StartTask(Sch, Cell->TaskId, Cell->Task, Cell->Delay, Cell->Period,
+                        SCH_MISS_DEFER, 0);
+        }
+      else
+        {
+          // Ignored if the task is gone already, a one-shot task that ran
+          Ctx_DeleteTask(Sch, Id_Slot(Sch, Cell->TaskId));
+        }
+      // The cell is free again for the producers of the next lap
+      atomic_store_explicit(&Cell->Seq, Queue->Head + SCH_CMD_QUEUE_SIZE, memory_order_release);
+      Queue->Head++;
+      Cell = &Queue->Cells[Queue->Head & CMD_MASK];
+    }
+}
+
+/*********************************************************************
+* Function : Ctx_ClearTask()
+*//**
+* \b Description:
+*
+* Utility function used to reset a task entry to the empty state.
+* It doesn't touch the timing wheel, the caller is responsible for that.
+*
+* PRE-CONDITION: TaskId < SCH_MAX_TASKS <br>
+* POST-CONDITION: The task entry is empty.
+*
+* @param Sch the scheduler instance.
+* @param TaskId The id of the task to be cleared.
+*
+* @return void
+*
+* @see Sch_DeleteTask
+*
+**********************************************************************/
+static void Ctx_ClearTask(Sch_t *Sch, const uint32_t TaskId)
+{
+  Sch->Config[TaskId].Task = NULL;
+#if SCH_LAYOUT == SCH_LAYOUT_SOA
+  // Idle lanes only expire every 2^bits ticks, and are masked out then
+  TASK_DELAY(Sch, TaskId) = SOA_IDLE;
+#else
+  TASK_DELAY(Sch, TaskId) = 0;
+#endif
+  BIT_CLEAR(Sch->Live, TaskId);
+  BIT_CLEAR(Sch->Timed, TaskId);
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+  BIT_CLEAR(Sch->Doomed, TaskId);
+#endif
+  // A post for the deleted task must not release the next one in the slot
+  atomic_fetch_and(&Sch->Posted[TaskId / 64u], ~((uint64_t)1 << (TaskId % 64u)));
+  BIT_CLEAR(Sch->Ready[Sch->Config[TaskId].Priority], TaskId);
+  Sch->Config[TaskId].Priority = SCH_PRIORITIES - 1;
+  Sch->Config[TaskId].Period = 0;
+  Sch->Config[TaskId].RunMe = 0;
+  Sch->Config[TaskId].Missed = 0;
+  Sch->Config[TaskId].WcetUs = 0;
+  Sch->Config[TaskId].AutoDelay = 0;
+  Sch->Config[TaskId].Event = 0;
+  Sch->Config[TaskId].Ctx = NULL;
+  Sch->Config[TaskId].Kind = TASK_PLAIN;
+#if SCH_STATS
+  Sch->Config[TaskId].Stats = (Sch_TaskStats_t){ .MinNs = UINT64_MAX };
+#endif
+#if SCH_SHM
+  Sch->Config[TaskId].Releases = 0;
+  Sch->Config[TaskId].Dispatches = 0;
+  Shm_PublishTask(Sch, TaskId);
+#endif
+}
+
+/*********************************************************************
+* Function : Sch_Update()
+*//**
+* \b Description:
+*
+* this function used to schedule the tasks at every tick. 
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The tasks are scheduled according to their configuration.
+*
+* @return void
+*
+* \b Example:
+* @code
+* Sch_Init();
+*
+* TimerHandler {
+*   Sch_Update();
+* }
+* @endcode
+*
+* @see Sch_Init
+*
+**********************************************************************/
+void Sch_Update(void)
+{
+  Ctx_Update(&Instances[0]);
+}
+
+/*********************************************************************
+* Function : Ctx_Update()
+*//**
+* \b Description:
+* Utility function used to run one scheduling round of one instance:
+* mark the due tasks, dispatch them, then sleep.
+*
+* @param Sch the scheduler instance.
+*
+* @return void
+*
+* @see Sch_Update
+**********************************************************************/
+static void Ctx_Update(Sch_t *Sch)
+{
+#if SCH_TRACE
+  const uint32_t Before = Sch->TickNow;
+#endif
+
+#if SCH_TRACE && SCH_TRACE_SIGNAL
+  Trace_DumpRequested(Sch);
+#endif
+  Ctx_ApplyCommands(Sch);
+#if SCH_CLOCK_DRIVEN
+  // Catch up with every tick that elapsed while sleeping
+  Ctx_Advance(Sch, (Sch_NowNs() - Sch->Epoch) / NS_PER_TICK + 1 - Sch->TickNow);
+#elif SCH_BACKEND == SCH_BACKEND_TIMERFD
+  // The timerfd counts every expiration, even the ones we were late for
+  Ctx_Advance(Sch, Sch->PendingTicks);
+#else
+  Ctx_Tick(Sch);
+#endif
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
+  Sch->PendingTicks = 0;
+#endif
+  TRACE(Sch, SCH_TRACE_TICK, Sch->TickNow, Sch->TickNow - Before);
+  
+  Ctx_Dispatch(Sch);
+
+  // The scheduler enters idle mode at this point
+  Ctx_GoToSleep(Sch);
+}
+
+/*********************************************************************
+* Function : Sch_Tick()
+*//**
+* \b Description:
+*
+* This function advances the scheduler by exactly one tick: the tasks
+* that are due get their RunMe incremented. It neither dispatches
+* the tasks nor sleeps, Sch_Update does that.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The due tasks are marked to run.
+*
+* @return void
+*
+* \b Example:
+* @code
+* Sch_Init();
+* Sch_AddTask(count, 0, 10);
+* Sch_Tick(); // count is due now
+* @endcode
+*
+* @see Sch_Update
+*
+**********************************************************************/
+void Sch_Tick(void)
+{
+  Ctx_ApplyCommands(&Instances[0]);
+  Ctx_Tick(&Instances[0]);
+  TRACE(&Instances[0], SCH_TRACE_TICK, Instances[0].TickNow, 1);
+}
+
+#if SCH_ENGINE == SCH_ENGINE_LINEAR
+/*********************************************************************
+* Function : Ctx_Tick()
+*//**
+* \b Description:
+* Utility function used to advance one instance by one tick, scanning
+* its whole task table.
+*
+* @param Sch the scheduler instance.
+*
+* @return void
+*
+* @see Sch_Tick
+**********************************************************************/
+static void Ctx_Tick(Sch_t *Sch)
+{
+  TaskConfig_t *Config = Sch->Config;
+  uint32_t Index;
+#if SCH_LAYOUT == SCH_LAYOUT_SOA
+  uint64_t Expired;
+  uint32_t Word;
+
+  for (Word = 0; Word < LIVE_WORDS; Word++)
+    {
+      // Only the tasks that expired are touched
+      Expired = Soa_Tick(&Sch->Delays[Word * 64u / SOA_LANES]) & Sch->Timed[Word];
+      while (Expired != 0)
+        {
+          Index = Word * 64u + (uint32_t)__builtin_ctzll(Expired);
+          Expired &= Expired - 1;
+          Ctx_Release(Sch, Index, 1);
+          if (Config[Index].Period == 0)
+            {
+              // A one-shot task is done with the clock
+              BIT_CLEAR(Sch->Timed, Index);
+              TASK_DELAY(Sch, Index) = SOA_IDLE;
+            }
+          else
+            {
+              TASK_DELAY(Sch, Index) = Config[Index].Period - 1;
+            }
+        }
+    }
+#else
+  uint64_t Bits;
+  uint32_t Word;
+
+  for (Word = 0; Word < LIVE_WORDS; Word++)
+    {
+      // Only the slots holding a task released by the clock are visited
+      for (Bits = Sch->Timed[Word]; Bits != 0; Bits &= Bits - 1)
+        {
+          Index = Word * 64u + (uint32_t)__builtin_ctzll(Bits);
+          if (Config[Index].Delay == 0)
+            {
+              // The task is due to run
+              Ctx_Release(Sch, Index, 1);
+              if (Config[Index].Period == 0)
+                {
+                  // A one-shot task is done with the clock
+                  BIT_CLEAR(Sch->Timed, Index);
+                }
+              else
+                {
+                  // Schedule periodic tasks to run again
+                  Config[Index].Delay = Config[Index].Period - 1;
+                }
+            }
+          else
+            {
+              // Not yet ready to run: just decrement the delay
+              Config[Index].Delay -= 1;
+            }
+        }
+    }
+#endif
+
+  Sch->TickNow++;
+  Sch->IdleStats.Ticks++;
+}
+
+#if SCH_LAYOUT == SCH_LAYOUT_SOA
+/*********************************************************************
+* Function : Soa_Tick()
+*//**
+* \b Description:
+* Utility function used to decrement 64 delays at once. A delay that
+* was 0 wraps to SOA_IDLE, which is how the expired lanes are found
+* again, only when a vector saw a 0.
+*
+* @param Delays the 64 delays, 64 / SOA_LANES vectors.
+*
+* @return uint64_t bit Lane set for each delay that was 0.
+*
+* @see Ctx_Tick
+**********************************************************************/
+static uint64_t Soa_Tick(SoaVec_t *Delays)
+{
+  uint64_t Expired = 0;
+  uint32_t Vector, Lane;
+#if defined(__GNUC__)
+  const SoaVec_t Zero = { 0 };
+  SoaVec_t Any = Zero;
+
+  for (Vector = 0; Vector < 64u / SOA_LANES; Vector++)
+    {
+      Any |= (SoaVec_t)(Delays[Vector] == Zero);
+      Delays[Vector] -= 1;
+    }
+  if (__builtin_memcmp(&Any, &Zero, sizeof(Any)) == 0)
+    {
+      return 0;
+    }
+#else
+  for (Vector = 0; Vector < 64u; Vector++)
+    {
+      Delays[Vector][0] -= 1;
+    }
+#endif
+
+  for (Lane = 0; Lane < 64u; Lane++)
+    {
+      Expired |= (uint64_t)(Delays[Lane / SOA_LANES][Lane % SOA_LANES] == SOA_IDLE) << Lane;
+    }
+  return Expired;
+}
+#endif
+#elif SCH_ENGINE == SCH_ENGINE_WHEEL
+/*********************************************************************
+* Function : Ctx_Tick()
+*//**
+* \b Description:
+* Utility function used to advance one instance by one tick, only
+* visiting the tasks of the current root slot of its timing wheel.
+*
+* @param Sch the scheduler instance.
+*
+* @return void
+*
+* @see Sch_Tick
+**********************************************************************/
+static void Ctx_Tick(Sch_t *Sch)
+{
+  TaskConfig_t *Config = Sch->Config;
+  uint32_t Index = Sch->TickNow & WHEEL_ROOT_MASK;
+  uint32_t TaskId;
+  uint32_t Next;
+
+  // Refill the root level from the upper levels once per root revolution
+  if (Index == 0 &&
+      Wheel_Cascade(Sch, 1, WHEEL_INDEX(Sch->TickNow, 1)) == 0 &&
+      Wheel_Cascade(Sch, 2, WHEEL_INDEX(Sch->TickNow, 2)) == 0 &&
+      Wheel_Cascade(Sch, 3, WHEEL_INDEX(Sch->TickNow, 3)) == 0)
+    {
+      Wheel_Cascade(Sch, 4, WHEEL_INDEX(Sch->TickNow, 4));
+    }
+
+  // Every task in the current root slot is due now
+  TaskId = Sch->Wheel[Index];
+  Sch->Wheel[Index] = WHEEL_NIL;
+  while (TaskId != WHEEL_NIL)
+    {
+      Next = Config[TaskId].Next;
+      // The task is due to run
+      Ctx_Release(Sch, TaskId, 1);
+      if (Config[TaskId].Period == 0)
+        {
+          // A one-shot task leaves the wheel
+          BIT_CLEAR(Sch->Timed, TaskId);
+        }
+      else
+        {
+          // Schedule periodic tasks to run again
+          Config[TaskId].Expiry += Config[TaskId].Period;
+          Wheel_Insert(Sch, TaskId);
+        }
+      TaskId = Next;
+    }
+
+  Sch->TickNow++;
+  Sch->IdleStats.Ticks++;
+}
+
+/*********************************************************************
+* Function : Wheel_Insert()
+*//**
+* \b Description:
+*
+* Utility function used to link a task in the wheel slot that matches
+* its Expiry. Near expiries go to the root level, far ones go to the
+* upper levels and are cascaded down as the wheel turns.
+*
+* PRE-CONDITION: The task isn't linked in any slot <br>
+* POST-CONDITION: The task is linked in the slot of its Expiry.
+*
+* @param Sch the scheduler instance.
+* @param TaskId The id of the task to be linked.
+*
+* @return void
+*
+* @see Wheel_Remove
+*
+**********************************************************************/
+static void Wheel_Insert(Sch_t *Sch, const uint32_t TaskId)
+{
+  TaskConfig_t *Config = Sch->Config;
+  uint32_t Expiry = Config[TaskId].Expiry;
+  uint32_t Delta = Expiry - Sch->TickNow;
+  uint32_t Slot;
+
+  if (Delta < WHEEL_ROOT_SIZE)
+    {
+      Slot = Expiry & WHEEL_ROOT_MASK;
+    }
+  else if (Delta < (1u << (WHEEL_ROOT_BITS + WHEEL_LVL_BITS)))
+    {
+      Slot = WHEEL_ROOT_SIZE + WHEEL_INDEX(Expiry, 1);
+    }
+  else if (Delta < (1u << (WHEEL_ROOT_BITS + 2 * WHEEL_LVL_BITS)))
+    {
+      Slot = WHEEL_ROOT_SIZE + WHEEL_LVL_SIZE + WHEEL_INDEX(Expiry, 2);
+    }
+  else if (Delta < (1u << (WHEEL_ROOT_BITS + 3 * WHEEL_LVL_BITS)))
+    {
+      Slot = WHEEL_ROOT_SIZE + 2 * WHEEL_LVL_SIZE + WHEEL_INDEX(Expiry, 3);
+    }
+  else
+    {
+      Slot = WHEEL_ROOT_SIZE + 3 * WHEEL_LVL_SIZE + WHEEL_INDEX(Expiry, 4);
+    }
+
+  Config[TaskId].Slot = Slot;
+  Config[TaskId].Prev = WHEEL_NIL;
+  Config[TaskId].Next = Sch->Wheel[Slot];
+  if (Sch->Wheel[Slot] != WHEEL_NIL)
+    {
+      Config[Sch->Wheel[Slot]].Prev = TaskId;
+    }
+  Sch->Wheel[Slot] = TaskId;
+}
+
+/*********************************************************************
+* Function : Wheel_Remove()
+*//**
+* \b Description:
+*
+* Utility function used to unlink a task from its wheel slot.
+*
+* PRE-CONDITION: The task is linked in a slot <br>
+* POST-CONDITION: The task isn't linked in any slot.
+*
+* @param Sch the scheduler instance.
+* @param TaskId The id of the task to be unlinked.
+*
+* @return void
+*
+* @see Wheel_Insert
+*
+**********************************************************************/
+static void Wheel_Remove(Sch_t *Sch, const uint32_t TaskId)
+{
+  TaskConfig_t *Config = Sch->Config;
+  uint32_t Next = Config[TaskId].Next;
+  uint32_t Prev = Config[TaskId].Prev;
+
+  if (Prev != WHEEL_NIL)
+    {
+      Config[Prev].Next = Next;
+    }
+  else
+    {
+      Sch->Wheel[Config[TaskId].Slot] = Next;
+    }
+  if (Next != WHEEL_NIL)
+    {
+      Config[Next].Prev = Prev;
+    }
+}
+
+/*********************************************************************
+* Function : Wheel_Cascade()
+*//**
+* \b Description:
+*
+* Utility function used to move the tasks of one upper level slot
+* down to the lower levels now that their expiry got closer.
+*
+* PRE-CONDITION: 1 <= Level <= WHEEL_LEVELS <br>
+* POST-CONDITION: The slot is empty and its tasks are re-linked.
+*
+* @param Sch the scheduler instance.
+* @param Level The wheel level of the slot.
+* @param Index The index of the slot inside its level.
+*
+* @return uint32_t Index, so that a zero index cascades the next level.
+*
+* @see Ctx_Tick
+*
+**********************************************************************/
+static uint32_t Wheel_Cascade(Sch_t *Sch, const uint32_t Level, const uint32_t Index)
+{
+  uint32_t Slot = WHEEL_ROOT_SIZE + (Level - 1) * WHEEL_LVL_SIZE + Index;
+  uint32_t TaskId = Sch->Wheel[Slot];
+  uint32_t Next;
+
+  Sch->Wheel[Slot] = WHEEL_NIL;
+  while (TaskId != WHEEL_NIL)
+    {
+      Next = Sch->Config[TaskId].Next;
+      Wheel_Insert(Sch, TaskId);
+      TaskId = Next;
+    }
+
+  return Index;
+}
+#else
+/*********************************************************************
+* Function : Ctx_Tick()
+*//**
+* \b Description:
+*
+* Utility function used to process one tick with the static schedule
+* table engine: the due tasks are read from the table generated offline
+* by tools/sch_table_gen, nothing is computed at runtime.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The RunMe of every task due this tick is incremented.
+*
+* @param Sch the scheduler instance.
+*
+* @return void
+*
+* @see Sch_Update
+**********************************************************************/
+static void Ctx_Tick(Sch_t *Sch)
+{
+  TaskConfig_t *Config = Sch->Config;
+  uint32_t TaskId;
+#ifdef SCH_TABLE_LIST
+  uint32_t Entry = SchTableStart[Sch->TableIndex];
+  uint32_t End = SchTableStart[Sch->TableIndex + 1];
+
+  for (; Entry < End; Entry++)
+    {
+      TaskId = SchTableIds[Entry];
+#else
+  SCH_TABLE_MASK_TYPE Mask = SchTable[Sch->TableIndex];
+
+  for (TaskId = 0; Mask != 0; TaskId++, Mask >>= 1)
+    {
+      if (!(Mask & 1))
+        {
+          continue;
+        }
+#endif
+      // A deleted task keeps its bits in the table
+      if (Config[TaskId].Task != NULL)
+        {
+          Ctx_Release(Sch, TaskId, 1);
+        }
+    }
+
+  if (++Sch->TableIndex == SCH_TABLE_LENGTH)
+    {
+      Sch->TableIndex = 0;
+    }
+  Sch->TickNow++;
+  Sch->IdleStats.Ticks++;
+}
+#endif
+
+/*********************************************************************
+* Function : Sch_Advance()
+*//**
+* \b Description:
+*
+* This function advances the scheduler by a number of ticks at once,
+* as if Sch_Tick was called Ticks times. A task that got due several
+* times meanwhile has its RunMe incremented once per release.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The tasks due during the elapsed ticks are marked to run.
+*
+* @param Ticks the number of elapsed ticks.
+*
+* @return void
+*
+* \b Example:
+* @code
+* Sch_Init();
+* Sch_AddTask(count, 0, 10);
+* Sch_Advance(25); // count is due 3 times
+* @endcode
+*
+* @see Sch_Tick
+*
+**********************************************************************/
+void Sch_Advance(const uint32_t Ticks)
+{
+  Ctx_ApplyCommands(&Instances[0]);
+  Ctx_Advance(&Instances[0], Ticks);
+  TRACE(&Instances[0], SCH_TRACE_TICK, Instances[0].TickNow, Ticks);
+}
+
+/*********************************************************************
+* Function : Ctx_Advance()
+*//**
+* \b Description:
+* Utility function used to advance one instance by a number of ticks.
+*
+* @param Sch the scheduler instance.
+* @param Ticks the number of elapsed ticks.
+*
+* @return void
+*
+* @see Sch_Advance
+**********************************************************************/
+static void Ctx_Advance(Sch_t *Sch, const uint32_t Ticks)
+{
+#if SCH_ENGINE == SCH_ENGINE_LINEAR
+  TaskConfig_t *Config = Sch->Config;
+  uint32_t Index, Word;
+  uint64_t Bits;
+  Sch_Tick_t Period;
+  uint32_t Rest;
+
+  if (Ticks == 0)
+    {
+      return;
+    }
+
+  for (Word = 0; Word < LIVE_WORDS; Word++)
+    {
+      for (Bits = Sch->Timed[Word]; Bits != 0; Bits &= Bits - 1)
+        {
+          Index = Word * 64u + (uint32_t)__builtin_ctzll(Bits);
+          if (TASK_DELAY(Sch, Index) >= Ticks)
+            {
+              TASK_DELAY(Sch, Index) -= Ticks;
+            }
+          else if (Config[Index].Period == 0)
+            {
+              // A one-shot task is released once, then done with the clock
+              Ctx_Release(Sch, Index, 1);
+              BIT_CLEAR(Sch->Timed, Index);
+#if SCH_LAYOUT == SCH_LAYOUT_SOA
+              TASK_DELAY(Sch, Index) = SOA_IDLE;
+#endif
+            }
+          else
+            {
+              // Released once when Delay hits 0, then once per period
+              Period = Config[Index].Period;
+              Rest = Ticks - 1 - TASK_DELAY(Sch, Index);
+              Ctx_Release(Sch, Index, 1 + Rest / Period);
+              TASK_DELAY(Sch, Index) = Period - 1 - Rest % Period;
+            }
+        }
+    }
+
+  Sch->TickNow += Ticks;
+  Sch->IdleStats.Ticks += Ticks;
+#else
+  uint32_t Tick;
+
+  // Empty ticks cost a slot lookup only
+  for (Tick = 0; Tick < Ticks; Tick++)
+    {
+      Ctx_Tick(Sch);
+    }
+#endif
+}
+
+/*********************************************************************
+* Function : Sch_GetIdleStats()
+*//**
+* \b Description:
+*
+* This function reports how many ticks were processed and how many times
+* the scheduler woke up to do so. In the classic mode both are equal,
+* in the tickless mode the difference is the number of saved wakeups.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: Stats holds the counters since Sch_Init.
+*
+* @param Stats where the counters are copied to.
+*
+* @return void
+*
+**********************************************************************/
+void Sch_GetIdleStats(Sch_IdleStats_t *Stats)
+{
+  *Stats = Instances[0].IdleStats;
+}
+
+/*********************************************************************
+* Function : Ctx_Release()
+*//**
+* \b Description:
+* Utility function used to release a task Count times at once. The
+* releases that come while a run is still pending are counted as
+* missed, and dropped if the task policy is SCH_MISS_SKIP.
+*
+* @param Sch the scheduler instance.
+* @param TaskId the released task.
+* @param Count the number of releases, > 0.
+*
+* @return void
+*
+* @see Ctx_Tick
+**********************************************************************/
+static inline void Ctx_Release(Sch_t *Sch, const uint32_t TaskId, const Sch_Tick_t Count)
+{
+  TaskConfig_t *Entry = &Sch->Config[TaskId];
+
+  // Ctx_Dispatch only visits the tasks with a pending run
+  BIT_SET(Sch->Ready[Entry->Priority], TaskId);
+  // The first release finding no pending run is on time
+  Entry->Missed += Count - (Entry->RunMe == 0 ? 1 : 0);
+#if SCH_SHM
+  Entry->Releases += Count;
+#endif
+  TRACE(Sch, SCH_TRACE_RELEASE, TaskId, Count);
+  if (Entry->Policy == SCH_MISS_SKIP)
+    {
+      Entry->RunMe = 1;
+    }
+  else
+    {
+      Entry->RunMe += Count;
+    }
+}
+
+/*********************************************************************
+* Function : Sch_GetMissedReleases()
+*//**
+* \b Description:
+*
+* This function reports how many releases of a task came while one of
+* its runs was still pending, i.e. couldn't run at their own tick. With
+* SCH_MISS_CATCH_UP or SCH_MISS_DEFER they ran late, with SCH_MISS_SKIP
+* they were dropped.
+* Use SCH_ABSTIME so lost timer wakeups are detected too.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: None.
+*
+* @param TaskId the id returned by Sch_AddTask.
+*
+* @return uint32_t the missed releases since the task was added, 0 for
+* an invalid id.
+*
+* @see Sch_AddTaskWithPolicy
+*
+**********************************************************************/
+uint32_t Sch_GetMissedReleases(const Sch_TaskId_t TaskId)
+{
+  const uint32_t Slot = Id_Slot(&Instances[0], TaskId);
+
+  if (Slot >= SCH_MAX_TASKS)
+    {
+      return 0;
+    }
+  return Instances[0].Config[Slot].Missed;
+}
+
+/*********************************************************************
+* Function : Sch_GetNextRelease()
+*//**
+* \b Description:
+*
+* This function reports the absolute CLOCK_MONOTONIC time a task is
+* released at next. Releases are kept as absolute ticks from the time
+* of tick 0, so they never drift from the clock however late the
+* wakeups are.
+*
+* PRE-CONDITION: Sch_Start() is called <br>
+* PRE-CONDITION: SCH_ABSTIME or SCH_TICKLESS is 1 <br>
+* POST-CONDITION: None.
+*
+* @param TaskId the id returned by Sch_AddTask.
+*
+* @return uint64_t the release time in ns, 0 for an invalid id or when
+* the ticks aren't clock driven.
+*
+* \b Example:
+* @code
+* uint64_t Next = Sch_GetNextRelease(taskId);
+* @endcode
+*
+**********************************************************************/
+uint64_t Sch_GetNextRelease(const Sch_TaskId_t TaskId)
+{
+#if SCH_CLOCK_DRIVEN
+  Sch_t *Sch = &Instances[0];
+  const uint32_t Slot = Id_Slot(Sch, TaskId);
+  uint64_t Tick;
+
+  if (Slot >= SCH_MAX_TASKS || !BIT_TEST(Sch->Timed, Slot))
+    {
+      return 0;
+    }
+#if SCH_ENGINE == SCH_ENGINE_WHEEL
+  Tick = Sch->Config[Slot].Expiry;
+#elif SCH_ENGINE == SCH_ENGINE_TABLE
+  Tick = Sch->TickNow + (TASK_DELAY(Sch, Slot) + Sch->Config[Slot].Period
+      - Sch->TickNow % Sch->Config[Slot].Period) % Sch->Config[Slot].Period;
+#else
+  Tick = (uint64_t)Sch->TickNow + TASK_DELAY(Sch, Slot);
+#endif
+  return Sch->Epoch + Tick * NS_PER_TICK;
+#else
+  (void)TaskId;
+  return 0;
+#endif
+}
+
+/*********************************************************************
+* Function : Sch_AddTaskAuto()
+*//**
+* \b Description:
+*
+* This function is used to add a task without choosing its Delay: the
+* scheduler picks the offset that minimises the peak per-tick load over
+* the hyperperiod of the task set, from the WCET estimates of the tasks.
+* Tasks added with Sch_AddTask count as 1 us each and keep their Delay.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* PRE-CONDITION: SCH_ENGINE isn't SCH_ENGINE_TABLE, whose offsets are
+* chosen offline <br>
+* POST-CONDITION: The task will be added to the scheduler, released for
+* the first time within Period ticks.
+*
+* @param Function a function pointer to the task function.
+* @param Period the period of the task, it must be > 0
+* @param WcetUs the estimated worst case run time of the task in us.
+*
+* @return Sch_TaskId_t the id of the task, or SCH_NO_TASK if the task
+* table is full, the period is 0 or the engine is SCH_ENGINE_TABLE.
+*
+* \b Example:
+* @code
+* Sch_Init();
+* for (Index = 0; Index < 300; Index++)
+*   {
+*     Sch_AddTaskAuto(Sensors[Index], 10, 150);
+*   }
+* @endcode
+*
+* @see Sch_Rebalance
+* @see Sch_GetPeakLoad
+*
+**********************************************************************/
+Sch_TaskId_t Sch_AddTaskAuto(void (*Function)(void),
+      const Sch_Tick_t Period,
+      const uint32_t WcetUs)
+{
+#if SCH_ENGINE != SCH_ENGINE_TABLE
+  Sch_t *Sch = &Instances[0];
+  Sch_TaskId_t TaskId;
+  uint32_t Horizon;
+
+  if (Period == 0)
+    {
+      return SCH_NO_TASK;
+    }
+  Horizon = Ctx_LoadProfile(Sch, Period, 0);
+  TaskId = Ctx_AddTask(Sch, Function, 0, Period, SCH_MISS_DEFER, 0);
+  if (TaskId != SCH_NO_TASK)
+    {
+      Sch->Config[TaskId].WcetUs = WcetUs;
+      Sch->Config[TaskId].AutoDelay = 1;
+      Ctx_SetPhase(Sch, TaskId, Ctx_BestPhase(Horizon, Period, WcetUs));
+    }
+  return Id_Make(Sch, TaskId);
+#else
+  (void)Function;
+  (void)Period;
+  (void)WcetUs;
+  return SCH_NO_TASK;
+#endif
+}
+
+/*********************************************************************
+* Function : Sch_Rebalance()
+*//**
+* \b Description:
+*
+* This function is used to spread again the offsets of the tasks added
+* with Sch_AddTaskAuto, e.g. after tasks were deleted or added at
+* runtime. They are placed again one by one, the heaviest first, around
+* the tasks whose Delay was given. A moved task is released once within
+* its period, its pending runs are kept.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The automatic offsets minimise the peak per-tick load
+* again.
+*
+* @return void
+*
+* \b Example:
+* @code
+* Sch_DeleteTask(Burst);
+* Sch_Rebalance();
+* @endcode
+*
+* @see Sch_AddTaskAuto
+*
+**********************************************************************/
+void Sch_Rebalance(void)
+{
+#if SCH_ENGINE != SCH_ENGINE_TABLE
+  Sch_t *Sch = &Instances[0];
+  TaskConfig_t *Config = Sch->Config;
+  uint32_t Horizon = Ctx_LoadProfile(Sch, 1, 1);
+  uint32_t TaskId, Heaviest;
+
+  for (TaskId = 0; TaskId < SCH_MAX_TASKS; TaskId++)
+    {
+      // Marks the automatic tasks still to place, not a doomed one (SCH_DISPATCH_STEALING)
+      Config[TaskId].AutoDelay = BIT_TEST(Sch->Timed, TaskId) &&
+                                 Config[TaskId].AutoDelay ? 2 : Config[TaskId].AutoDelay;
+    }
+  do
+    {
+      // The heaviest load per tick first, it has the fewest good slots
+      Heaviest = SCH_MAX_TASKS;
+      for (TaskId = 0; TaskId < SCH_MAX_TASKS; TaskId++)
+        {
+          if (Config[TaskId].AutoDelay == 2 &&
+              (Heaviest == SCH_MAX_TASKS ||
+               (uint64_t)Config[TaskId].WcetUs * Config[Heaviest].Period >
+               (uint64_t)Config[Heaviest].WcetUs * Config[TaskId].Period))
+            {
+              Heaviest = TaskId;
+            }
+        }
+      if (Heaviest != SCH_MAX_TASKS)
+        {
+          Config[Heaviest].AutoDelay = 1;
+          Ctx_SetPhase(Sch, Heaviest, Ctx_BestPhase(Horizon,
+              Config[Heaviest].Period, Config[Heaviest].WcetUs));
+          Ctx_AddLoad(Horizon, Ctx_Phase(Sch, Heaviest),
+              Config[Heaviest].Period, Config[Heaviest].WcetUs);
+        }
+    }
+  while (Heaviest != SCH_MAX_TASKS);
+#endif
+}
+
+/*********************************************************************
+* Function : Sch_GetPeakLoad()
+*//**
+* \b Description:
+*
+* This function reports the highest sum of WCET estimates released in a
+* single tick over the hyperperiod, to compare with the tick length.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: None.
+*
+* @return uint32_t the peak per-tick load in us, 0 with SCH_ENGINE_TABLE.
+*
+* @see Sch_AddTaskAuto
+*
+**********************************************************************/
+uint32_t Sch_GetPeakLoad(void)
+{
+  uint32_t Peak = 0;
+#if SCH_ENGINE != SCH_ENGINE_TABLE
+  uint32_t Horizon = Ctx_LoadProfile(&Instances[0], 1, 0);
+  uint32_t Tick;
+
+  for (Tick = 0; Tick < Horizon; Tick++)
+    {
+      if (BalanceLoad[Tick] > Peak)
+        {
+          Peak = BalanceLoad[Tick];
+        }
+    }
+#endif
+  return Peak;
+}
+
+#if SCH_ENGINE != SCH_ENGINE_TABLE
+/*********************************************************************
+* Function : Ctx_LoadProfile()
+*//**
+* \b Description:
+* Utility function used to build in BalanceLoad the per-tick load of
+* the task set over its hyperperiod (including Period), capped to
+* SCH_BALANCE_MAX_HYPER ticks. Tick t of the profile stands for every
+* absolute tick congruent to t modulo the horizon.
+*
+* @param Sch the scheduler instance.
+* @param Period the period of a task about to be added, 1 if none.
+* @param Fixed 1 to leave the automatic tasks out of the profile.
+*
+* @return uint32_t the horizon of the profile in ticks.
+*
+* @see Sch_AddTaskAuto
+**********************************************************************/
+static uint32_t Ctx_LoadProfile(Sch_t *Sch, const Sch_Tick_t Period, const uint8_t Fixed)
+{
+  TaskConfig_t *Config = Sch->Config;
+  uint64_t Horizon = Period;
+  uint64_t A, B, Rest;
+  uint32_t TaskId;
+
+  // The LCM of the periods, or the cap
+  for (TaskId = 0; TaskId < SCH_MAX_TASKS && Horizon <= SCH_BALANCE_MAX_HYPER; TaskId++)
+    {
+      if (BIT_TEST(Sch->Timed, TaskId) && Config[TaskId].Period != 0)
+        {
+          for (A = Horizon, B = Config[TaskId].Period; B != 0; A = B, B = Rest)
+            {
+              Rest = A % B;
+            }
+          Horizon = Horizon / A * Config[TaskId].Period;
+        }
+    }
+  if (Horizon > SCH_BALANCE_MAX_HYPER)
+    {
+      Horizon = SCH_BALANCE_MAX_HYPER;
+    }
+
+  memset(BalanceLoad, 0, Horizon * sizeof(BalanceLoad[0]));
+  for (TaskId = 0; TaskId < SCH_MAX_TASKS; TaskId++)
+    {
+      // One-shot and event tasks have no periodic load, doomed ones none at all
+      if (BIT_TEST(Sch->Timed, TaskId) && Config[TaskId].Period != 0 &&
+          !(Fixed && Config[TaskId].AutoDelay))
+        {
+          Ctx_AddLoad(Horizon, Ctx_Phase(Sch, TaskId), Config[TaskId].Period,
+                      Config[TaskId].WcetUs);
+        }
+    }
+  return Horizon;
+}
+
+/*********************************************************************
+* Function : Ctx_AddLoad()
+*//**
+* \b Description:
+* Utility function used to add the releases of a task to BalanceLoad.
+*
+* @param Horizon the profile length in ticks.
+* @param Phase the task release tick modulo its period.
+* @param Period the task period.
+* @param WcetUs the task WCET, 0 counts as 1 us.
+*
+* @return void
+**********************************************************************/
+static void Ctx_AddLoad(const uint32_t Horizon, const uint32_t Phase,
+      const Sch_Tick_t Period, const uint32_t WcetUs)
+{
+  uint32_t Tick;
+
+  for (Tick = Phase; Tick < Horizon; Tick += Period)
+    {
+      BalanceLoad[Tick] += WcetUs ? WcetUs : 1;
+    }
+}
+
+/*********************************************************************
+* Function : Ctx_BestPhase()
+*//**
+* \b Description:
+* Utility function used to find the phase of a new task that keeps the
+* peak of BalanceLoad the lowest, the least loaded one on a tie.
+*
+* @param Horizon the profile length in ticks.
+* @param Period the period of the new task.
+* @param WcetUs the WCET of the new task.
+*
+* @return uint32_t the best release tick modulo Period.
+**********************************************************************/
+static uint32_t Ctx_BestPhase(const uint32_t Horizon, const Sch_Tick_t Period,
+      const uint32_t WcetUs)
+{
+  uint64_t Peak, Sum, BestPeak = UINT64_MAX, BestSum = UINT64_MAX;
+  uint32_t Phase, Best = 0, Tick;
+
+  (void)WcetUs; // Adds the same amount to every candidate
+  for (Phase = 0; Phase < Period && Phase < Horizon; Phase++)
+    {
+      Peak = 0;
+      Sum = 0;
+      for (Tick = Phase; Tick < Horizon; Tick += Period)
+        {
+          Sum += BalanceLoad[Tick];
+          if (BalanceLoad[Tick] > Peak)
+            {
+              Peak = BalanceLoad[Tick];
+            }
+        }
+      if (Peak < BestPeak || (Peak == BestPeak && Sum < BestSum))
+        {
+          BestPeak = Peak;
+          BestSum = Sum;
+          Best = Phase;
+        }
+    }
+  return Best;
+}
+
+/*********************************************************************
+* Function : Ctx_Phase()
+*//**
+* \b Description:
+* Utility function used to get the next release tick of a task modulo
+* its period.
+*
+* @param Sch the scheduler instance.
+* @param TaskId a task of the instance.
+*
+* @return uint32_t the release phase, < Period.
+**********************************************************************/
+static uint32_t Ctx_Phase(Sch_t *Sch, const uint32_t TaskId)
+{
+#if SCH_ENGINE == SCH_ENGINE_WHEEL
+  return Sch->Config[TaskId].Expiry % Sch->Config[TaskId].Period;
+#else
+  return ((uint64_t)Sch->TickNow + TASK_DELAY(Sch, TaskId)) % Sch->Config[TaskId].Period;
+#endif
+}
+
+/*********************************************************************
+* Function : Ctx_SetPhase()
+*//**
+* \b Description:
+* Utility function used to move the next release of a task to the first
+* tick from TickNow on that is congruent to Phase modulo its period.
+*
+* @param Sch the scheduler instance.
+* @param TaskId a task of the instance.
+* @param Phase the new release phase, < Period.
+*
+* @return void
+**********************************************************************/
+static void Ctx_SetPhase(Sch_t *Sch, const uint32_t TaskId, const uint32_t Phase)
+{
+  TaskConfig_t *Entry = &Sch->Config[TaskId];
+
+  TASK_DELAY(Sch, TaskId) = (Phase + Entry->Period - Sch->TickNow % Entry->Period) % Entry->Period;
+#if SCH_ENGINE == SCH_ENGINE_WHEEL
+  Wheel_Remove(Sch, TaskId);
+  Entry->Expiry = Sch->TickNow + TASK_DELAY(Sch, TaskId);
+  Wheel_Insert(Sch, TaskId);
+#endif
+}
+#endif
+
+/*********************************************************************
+* Function : Sch_GetTaskStats()
+*//**
+* \b Description:
+*
+* This function reports the run time statistics of a task of instance 0:
+* how many times it ran, its min/max/mean run time, a log2 histogram of
+* its run times and how many runs took longer than a tick.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* PRE-CONDITION: SCH_STATS is 1 <br>
+* POST-CONDITION: Stats holds the counters since the task was added.
+*
+* @param TaskId the id returned by Sch_AddTask.
+* @param Stats where the counters are copied to.
+*
+* @return int 0 on success, -1 if TaskId is invalid or SCH_STATS is 0.
+*
+* \b Example:
+* @code
+* Sch_TaskStats_t Stats;
+* if (Sch_GetTaskStats(TaskId, &Stats) == 0)
+*   {
+*     printf("max %" PRIu64 " ns\n", Stats.MaxNs);
+*   }
+* @endcode
+*
+* @see Sch_GetStats
+*
+**********************************************************************/
+int Sch_GetTaskStats(const Sch_TaskId_t TaskId, Sch_TaskStats_t *Stats)
+{
+  return Sch_GetTaskStatsOnCore(0, TaskId, Stats);
+}
+
+/*********************************************************************
+* Function : Sch_GetTaskStatsOnCore()
+*//**
+* \b Description:
+*
+* This function is the Sch_GetTaskStats of a given core instance. The
+* counters of a running core are read without locking, a value may be
+* one run behind the others.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: Stats holds the counters since the task was added.
+*
+* @param Core the instance index, less than SCH_MAX_CORES.
+* @param TaskId the id returned by Sch_AddTaskOnCore.
+* @param Stats where the counters are copied to.
+*
+* @return int 0 on success, -1 if Core or TaskId is invalid or SCH_STATS
+* is 0.
+*
+* @see Sch_GetTaskStats
+*
+**********************************************************************/
+int Sch_GetTaskStatsOnCore(const uint32_t Core, const Sch_TaskId_t TaskId,
+      Sch_TaskStats_t *Stats)
+{
+#if SCH_STATS
+  TaskConfig_t *Entry;
+  uint32_t Slot;
+
+  if (Core >= SCH_MAX_CORES)
+    {
+      return -1;
+    }
+  Slot = Id_Slot(&Instances[Core], TaskId);
+  if (Slot >= SCH_MAX_TASKS)
+    {
+      return -1;
+    }
+  Entry = &Instances[Core].Config[Slot];
+  if (Entry->Task == NULL)
+    {
+      return -1;
+    }
+
+  *Stats = Entry->Stats;
+  Stats->MeanNs = Stats->Runs ? Stats->TotalNs / Stats->Runs : 0;
+  if (Stats->Runs == 0)
+    {
+      Stats->MinNs = 0;
+    }
+  return 0;
+#else
+  (void)Core;
+  (void)TaskId;
+  (void)Stats;
+  return -1;
+#endif
+}
+
+/*********************************************************************
+* Function : Sch_GetStats()
+*//**
+* \b Description:
+*
+* This function reports the dispatch statistics of instance 0: the task
+* runs it started, their latency from the nominal time of the tick they
+* were dispatched in, and the RunMe backlog met at dispatch time.
+* Latencies are only measured once Sch_Start is called.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: Stats holds the counters since Sch_Init, all 0 if
+* SCH_STATS is 0.
+*
+* @param Stats where the counters are copied to.
+*
+* @return void
+*
+* @see Sch_GetTaskStats
+*
+**********************************************************************/
+void Sch_GetStats(Sch_Stats_t *Stats)
+{
+  Sch_GetStatsOnCore(0, Stats);
+}
+
+/*********************************************************************
+* Function : Sch_GetStatsOnCore()
+*//**
+* \b Description:
+*
+* This function is the Sch_GetStats of a given core instance.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: Stats holds the counters since Sch_Init.
+*
+* @param Core the instance index, less than SCH_MAX_CORES.
+* @param Stats where the counters are copied to.
+*
+* @return void
+*
+* @see Sch_GetStats
+*
+**********************************************************************/
+void Sch_GetStatsOnCore(const uint32_t Core, Sch_Stats_t *Stats)
+{
+  *Stats = (Sch_Stats_t){ 0 };
+#if SCH_STATS
+  if (Core >= SCH_MAX_CORES)
+    {
+      return;
+    }
+  *Stats = Instances[Core].Stats;
+  if (Stats->LatencyMinNs == UINT64_MAX)
+    {
+      Stats->LatencyMinNs = 0;
+    }
+  else
+    {
+      // Dispatches also counts the batch instances and the unmeasured runs
+      Stats->LatencyMeanNs = Stats->LatencyTotalNs / Stats->LatencySamples;
+    }
+#else
+  (void)Core;
+#endif
+}
+
+#if SCH_STATS
+/*********************************************************************
+* Function : Stats_Record()
+*//**
+* \b Description:
+* Utility function used to account one task run in its statistics.
+*
+* @param Stats the task statistics.
+* @param Ns the run time.
+*
+* @return void
+*
+* @see Ctx_Run
+**********************************************************************/
+static void Stats_Record(Sch_TaskStats_t *Stats, const uint64_t Ns)
+{
+  uint64_t Us = Ns / 1000;
+  uint32_t Bucket = 0;
+
+  // Bucket i holds runs in [2^(i-1), 2^i) us
+  while (Bucket < SCH_STATS_BUCKETS - 1 && (Us >> Bucket) != 0)
+    {
+      Bucket++;
+    }
+
+  STATS_ADD(Stats->Runs, 1);
+  STATS_ADD(Stats->TotalNs, Ns);
+  STATS_ADD(Stats->Histogram[Bucket], 1);
+  if (Ns > NS_PER_TICK)
+    {
+      STATS_ADD(Stats->Overruns, 1);
+    }
+  Stats_Min(&Stats->MinNs, Ns);
+  Stats_Max(&Stats->MaxNs, Ns);
+}
+
+/*********************************************************************
+* Function : Stats_Min()
+*//**
+* \b Description:
+* Utility function used to lower a minimum, atomically when tasks may be
+* stolen.
+*
+* @param Min the minimum.
+* @param Value the new sample.
+*
+* @return void
+**********************************************************************/
+static void Stats_Min(uint64_t *Min, const uint64_t Value)
+{
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+  uint64_t Old = __atomic_load_n(Min, __ATOMIC_RELAXED);
+
+  while (Value < Old &&
+         !__atomic_compare_exchange_n(Min, &Old, Value, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+#else
+  if (Value < *Min)
+    {
+      *Min = Value;
+    }
+#endif
+}
+
+/*********************************************************************
+* Function : Stats_Max()
+*//**
+* \b Description:
+* Utility function used to raise a maximum, atomically when tasks may be
+* stolen.
+*
+* @param Max the maximum.
+* @param Value the new sample.
+*
+* @return void
+**********************************************************************/
+static void Stats_Max(uint64_t *Max, const uint64_t Value)
+{
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+  uint64_t Old = __atomic_load_n(Max, __ATOMIC_RELAXED);
+
+  while (Value > Old &&
+         !__atomic_compare_exchange_n(Max, &Old, Value, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+#else
+  if (Value > *Max)
+    {
+      *Max = Value;
+    }
+#endif
+}
+#endif
+
+/*********************************************************************
+* Function : Sch_ShmOpen()
+*//**
+* \b Description:
+*
+* This function is used to publish the scheduler counters to a POSIX
+* shared memory segment (layout in sch_shm.h), so tools/sch_top can
+* watch them from another process. Each instance then updates its task
+* entries in the dispatch rounds that visit them and its own entry at
+* the end of every round, with plain stores under a sequence lock: the
+* tick path makes no system call for it. The segment is prefaulted here.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* PRE-CONDITION: Sch_Start() or Sch_StartCores() isn't called yet <br>
+* POST-CONDITION: The segment holds the current counters, it's removed
+* by Sch_Deinit.
+*
+* @param Name the shared memory object name, e.g. "/sch.<pid>".
+*
+* @return int 0 on success, -1 with errno set on failure or if SCH_SHM
+* is 0.
+*
+* \b Example:
+* @code
+* char Name[32];
+* snprintf(Name, sizeof(Name), "/sch.%d", (int)getpid());
+* if (Sch_ShmOpen(Name) != 0)
+*   {
+*     perror("Sch_ShmOpen");
+*   }
+* @endcode
+*
+* @see Sch_Deinit
+*
+**********************************************************************/
+int Sch_ShmOpen(const char *Name)
+{
+#if SCH_SHM
+  Sch_ShmHeader_t *Header;
+  uint32_t Core, TaskId;
+  size_t Size = sizeof(Sch_ShmHeader_t) + SCH_MAX_CORES * sizeof(Sch_ShmCore_t) +
+    (size_t)SCH_MAX_CORES * SCH_MAX_TASKS * sizeof(Sch_ShmTask_t);
+  void *Map;
+  int Fd;
+
+  if (Shm != NULL || strlen(Name) >= sizeof(ShmName))
+    {
+      errno = Shm != NULL ? EBUSY : ENAMETOOLONG;
+      return -1;
+    }
+  Fd = shm_open(Name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+  if (Fd == -1)
+    {
+      return -1;
+    }
+  if (ftruncate(Fd, (off_t)Size) == -1)
+    {
+      close(Fd);
+      shm_unlink(Name);
+      return -1;
+    }
+  Map = mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+  close(Fd);
+  if (Map == MAP_FAILED)
+    {
+      shm_unlink(Name);
+      return -1;
+    }
+  // Touch every page now rather than from the tick path
+  memset(Map, 0, Size);
+  Header = Map;
+  Header->Version = SCH_SHM_VERSION;
+  Header->Flags = SCH_STATS ? SCH_SHM_TIMED : 0;
+  Header->Cores = SCH_MAX_CORES;
+  Header->MaxTasks = SCH_MAX_TASKS;
+  Header->CoreSize = sizeof(Sch_ShmCore_t);
+  Header->TaskSize = sizeof(Sch_ShmTask_t);
+  Header->TickUs = TICK * 1000u;
+  Header->Pid = getpid();
+  Header->Size = Size;
+  strcpy(ShmName, Name);
+  ShmSize = Size;
+  Shm = Map;
+
+  // The tasks added so far
+  for (Core = 0; Core < SCH_MAX_CORES; Core++)
+    {
+      for (TaskId = 0; TaskId < SCH_MAX_TASKS; TaskId++)
+        {
+          Shm_PublishTask(&Instances[Core], TaskId);
+        }
+      Shm_PublishCore(&Instances[Core]);
+    }
+  // Readers wait for the magic
+  __atomic_store_n(&Header->Magic, SCH_SHM_MAGIC, __ATOMIC_RELEASE);
+  return 0;
+#else
+  (void)Name;
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+#if SCH_SHM
+/*********************************************************************
+* Function : Shm_PublishTask()
+*//**
+* \b Description:
+* Utility function used to copy the counters of a task slot to its
+* segment entry, if the segment is open. Only the thread running Sch
+* calls it; the run times of an instance stolen by another worker show
+* up in the next round that visits the task.
+*
+* @param Sch the scheduler instance.
+* @param TaskId the slot.
+*
+* @return void
+*
+* @see Sch_ShmOpen
+**********************************************************************/
+static void Shm_PublishTask(Sch_t *Sch, const uint32_t TaskId)
+{
+  TaskConfig_t *Entry = &Sch->Config[TaskId];
+  Sch_ShmTask_t *Task;
+
+  if (Shm == NULL)
+    {
+      return;
+    }
+  Task = (Sch_ShmTask_t *)(Shm + sizeof(Sch_ShmHeader_t) +
+                           SCH_MAX_CORES * sizeof(Sch_ShmCore_t)) +
+    (size_t)(Sch - Instances) * SCH_MAX_TASKS + TaskId;
+  Shm_WriteBegin(&Task->Seq);
+  Task->Live = Entry->Task != NULL;
+  Task->Period = Entry->Period;
+  Task->RunMe = Entry->RunMe;
+  Task->Releases = Entry->Releases;
+  Task->Dispatches = __atomic_load_n(&Entry->Dispatches, __ATOMIC_RELAXED);
+  Task->Missed = Entry->Missed;
+#if SCH_STATS
+  Task->Overruns = __atomic_load_n(&Entry->Stats.Overruns, __ATOMIC_RELAXED);
+  Task->MinNs = Entry->Stats.Runs ? __atomic_load_n(&Entry->Stats.MinNs, __ATOMIC_RELAXED) : 0;
+  Task->MaxNs = __atomic_load_n(&Entry->Stats.MaxNs, __ATOMIC_RELAXED);
+  Task->TotalNs = __atomic_load_n(&Entry->Stats.TotalNs, __ATOMIC_RELAXED);
+#endif
+  Shm_WriteEnd(&Task->Seq);
+}
+
+/*********************************************************************
+* Function : Shm_PublishCore()
+*//**
+* \b Description:
+* Utility function used to copy the counters of an instance to its
+* segment entry, if the segment is open.
+*
+* @param Sch the scheduler instance.
+*
+* @return void
+*
+* @see Sch_ShmOpen
+**********************************************************************/
+static void Shm_PublishCore(Sch_t *Sch)
+{
+  Sch_ShmCore_t *Core;
+
+  if (Shm == NULL)
+    {
+      return;
+    }
+  Core = (Sch_ShmCore_t *)(Shm + sizeof(Sch_ShmHeader_t)) + (Sch - Instances);
+  Shm_WriteBegin(&Core->Seq);
+  Core->Ticks = Sch->IdleStats.Ticks;
+  Core->Wakeups = Sch->IdleStats.Wakeups;
+  Core->Rounds = Sch->Rounds;
+#if SCH_STATS
+  Core->Dispatches = Sch->Stats.Dispatches;
+  Core->Backlog = Sch->Stats.Backlog;
+  Core->MaxBacklog = Sch->Stats.MaxBacklog;
+  Core->BudgetCuts = Sch->Stats.BudgetCuts;
+  Core->LatencyMaxNs = Sch->Stats.LatencyMaxNs;
+  Core->LatencyTotalNs = Sch->Stats.LatencyTotalNs;
+  Core->LatencySamples = Sch->Stats.LatencySamples;
+#endif
+  Shm_WriteEnd(&Core->Seq);
+}
+#endif
+
+/*********************************************************************
+* Function : Sch_TraceDump()
+*//**
+* \b Description:
+*
+* This function is used to write the trace of every instance to a file
+* (layout in sch_trace.h), oldest event first, e.g. right after a missed
+* deadline is noticed. It may be called from any thread while the
+* instances run: the events overwritten during the copy are dropped and
+* counted as lost. tools/sch_trace2json converts the file for
+* chrome://tracing or Perfetto.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: Path holds the last SCH_TRACE_SIZE events of every
+* instance.
+*
+* @param Path the file to write.
+*
+* @return int 0 on success, -1 with errno set on failure or if
+* SCH_TRACE is 0.
+*
+* \b Example:
+* @code
+* if (Sch_GetMissedReleases(TaskId) != 0)
+*   {
+*     Sch_TraceDump("missed.bin");
+*   }
+* @endcode
+*
+* @see Sch_Init
+*
+**********************************************************************/
+int Sch_TraceDump(const char *Path)
+{
+#if SCH_TRACE
+  Sch_TraceHeader_t Header = {
+    .Magic = SCH_TRACE_MAGIC,
+    .Version = SCH_TRACE_VERSION,
+    .Cores = SCH_MAX_CORES,
+    .TickUs = TICK * 1000u,
+    .Pid = getpid(),
+    .EventSize = sizeof(Sch_TraceEvent_t),
+  };
+  Sch_TraceEvent_t *Events = malloc(SCH_TRACE_SIZE * sizeof(Sch_TraceEvent_t));
+  Sch_TraceBlock_t Block;
+  uint64_t Head, First, Index, Skip;
+  uint32_t Core;
+  FILE *Out;
+  int Status = 0;
+
+  if (Events == NULL)
+    {
+      return -1;
+    }
+  Out = fopen(Path, "wb");
+  if (Out == NULL)
+    {
+      free(Events);
+      return -1;
+    }
+  fwrite(&Header, sizeof(Header), 1, Out);
+  for (Core = 0; Core < SCH_MAX_CORES; Core++)
+    {
+      Sch_t *Sch = &Instances[Core];
+
+      Head = atomic_load_explicit(&Sch->TraceHead, memory_order_acquire);
+      First = Head > SCH_TRACE_SIZE ? Head - SCH_TRACE_SIZE : 0;
+      for (Index = First; Index < Head; Index++)
+        {
+          Events[Index - First] = Sch->Trace[Index & TRACE_MASK];
+        }
+      atomic_thread_fence(memory_order_acquire);
+      // The event being written when the copy ended may overwrite one more
+      Skip = atomic_load_explicit(&Sch->TraceHead, memory_order_relaxed) + 1;
+      Skip = Skip > First + SCH_TRACE_SIZE ? Skip - First - SCH_TRACE_SIZE : 0;
+      Skip = Skip < Head - First ? Skip : Head - First;
+      Block.Core = Core;
+      Block.Count = (uint32_t)(Head - First - Skip);
+      Block.Lost = First + Skip;
+      fwrite(&Block, sizeof(Block), 1, Out);
+      fwrite(Events + Skip, sizeof(Sch_TraceEvent_t), Block.Count, Out);
+    }
+  if (ferror(Out))
+    {
+      Status = -1;
+    }
+  if (fclose(Out) != 0)
+    {
+      Status = -1;
+    }
+  free(Events);
+  return Status;
+#else
+  (void)Path;
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+#if SCH_TRACE
+/*********************************************************************
+* Function : Trace_Now()
+*//**
+* \b Description:
+* Utility function used to read the trace clock, CLOCK_MONOTONIC_RAW:
+* it isn't slewed by NTP, so the spacing of the events is the real one.
+* With SCH_BACKEND_SIM it's the virtual clock.
+*
+* @return uint64_t the time in ns.
+**********************************************************************/
+static inline uint64_t Trace_Now(void)
+{
+#if SCH_SIM
+  return SimNowNs;
+#else
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC_RAW, &Now);
+  return (uint64_t)Now.tv_sec * NS_PER_SEC + (uint64_t)Now.tv_nsec;
+#endif
+}
+
+/*********************************************************************
+* Function : Trace_Record()
+*//**
+* \b Description:
+* Utility function used to append an event to the ring of an instance,
+* overwriting the oldest one. Only the thread running Sch calls it, the
+* event is published by the release store of TraceHead.
+*
+* @param Sch the scheduler instance of the running thread.
+* @param Type the event type.
+* @param Id, Arg the event data, Arg saturated to 16 bits.
+* @param Owner the instance of the task.
+* @param Ns the event time.
+*
+* @return void
+*
+* @see Sch_TraceDump
+**********************************************************************/
+static inline void Trace_Record(Sch_t *Sch, const Sch_TraceType_t Type, const uint32_t Id,
+      const uint32_t Arg, const uint8_t Owner, const uint64_t Ns)
+{
+  uint64_t Head = atomic_load_explicit(&Sch->TraceHead, memory_order_relaxed);
+  Sch_TraceEvent_t *Event = &Sch->Trace[Head & TRACE_MASK];
+
+#if SCH_SIM
+  // Sch_SimTrace keeps every event: the ring is written out before it wraps
+  if (SimTrace != NULL && Head - SimFlushed == SCH_TRACE_SIZE)
+    {
+      Sim_Flush(Sch, 0);
+    }
+#endif
+  Event->Ns = Ns;
+  Event->Id = Id;
+  Event->Arg = Arg > UINT16_MAX ? UINT16_MAX : (uint16_t)Arg;
+  Event->Type = (uint8_t)Type;
+  Event->Owner = Owner;
+  atomic_store_explicit(&Sch->TraceHead, Head + 1, memory_order_release);
+}
+
+/*********************************************************************
+* Function : Trace_TaskId()
+*//**
+* \b Description:
+* Utility function used to find the slot and the instance of a task
+* entry, which may belong to another instance than the running one.
+*
+* @param Entry the task.
+* @param Owner where its instance index is stored.
+*
+* @return uint32_t its task id.
+**********************************************************************/
+static uint32_t Trace_TaskId(const TaskConfig_t *Entry, uint8_t *Owner)
+{
+  uint32_t Core = (uint32_t)(((const uint8_t *)Entry - (const uint8_t *)Instances) / sizeof(Sch_t));
+
+  *Owner = (uint8_t)Core;
+  return (uint32_t)(Entry - Instances[Core].Config);
+}
+
+#if SCH_TRACE_SIGNAL
+/*********************************************************************
+* Function : TraceHandler()
+*//**
+* \b Description:
+* Utility function: the SCH_TRACE_SIGNAL handler. The dump itself isn't
+* async-signal-safe, it's left to the Sch_Start thread.
+*
+* @param Signal SCH_TRACE_SIGNAL
+*
+* @return void
+**********************************************************************/
+static void TraceHandler(int Signal)
+{
+  (void)Signal;
+  TraceRequested = 1;
+}
+
+/*********************************************************************
+* Function : Trace_DumpRequested()
+*//**
+* \b Description:
+* Utility function used to write the dump asked for by SCH_TRACE_SIGNAL,
+* if any, to SCH_TRACE_PATH. Instance 0 only.
+*
+* @param Sch the instance that woke up
+*
+* @return void
+*
+* @see Sch_TraceDump
+**********************************************************************/
+static void Trace_DumpRequested(Sch_t *Sch)
+{
+  char Path[PATH_MAX];
+
+  if (!TraceRequested || Sch != &Instances[0])
+    {
+      return;
+    }
+  TraceRequested = 0;
+
+  snprintf(Path, sizeof(Path), SCH_TRACE_PATH, (int)getpid());
+  if (Sch_TraceDump(Path) != 0)
+    {
+      perror(Path);
+    }
+  else
+    {
+      fprintf(stderr, "sch: trace written to %s\n", Path);
+    }
+}
+#endif
+#endif
+
+#if SCH_TICKLESS
+/*********************************************************************
+* Function : Ctx_NextDue()
+*//**
+* \b Description:
+*
+* Utility function used to find how many ticks after TickNow the next
+* task is due. It's capped by SCH_TICKLESS_MAX_IDLE, and the wheel engine
+* also stops at the end of the root revolution where it has to cascade.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: None.
+*
+* @param Sch the scheduler instance.
+*
+* @return uint32_t ticks until the next release, 0 for the very next tick.
+*
+* @see Ctx_GoToSleep
+*
+**********************************************************************/
+static uint32_t Ctx_NextDue(Sch_t *Sch)
+{
+  uint32_t NextDue = SCH_TICKLESS_MAX_IDLE;
+  uint32_t Index;
+
+#if SCH_ENGINE == SCH_ENGINE_LINEAR
+  uint32_t Word;
+  uint64_t Bits;
+
+  for (Word = 0; Word < LIVE_WORDS; Word++)
+    {
+      for (Bits = Sch->Timed[Word]; Bits != 0; Bits &= Bits - 1)
+        {
+          Index = Word * 64u + (uint32_t)__builtin_ctzll(Bits);
+          if (TASK_DELAY(Sch, Index) < NextDue)
+            {
+              NextDue = TASK_DELAY(Sch, Index);
+            }
+        }
+    }
+#elif SCH_ENGINE == SCH_ENGINE_TABLE
+  uint32_t Entry = Sch->TableIndex;
+
+  for (Index = 0; Index < NextDue; Index++)
+    {
+#ifdef SCH_TABLE_LIST
+      if (SchTableStart[Entry] != SchTableStart[Entry + 1])
+#else
+      if (SchTable[Entry] != 0)
+#endif
+        {
+          return Index;
+        }
+      if (++Entry == SCH_TABLE_LENGTH)
+        {
+          Entry = 0;
+        }
+    }
+#else
+  uint32_t Root = Sch->TickNow & WHEEL_ROOT_MASK;
+
+  if (Root == 0)
+    {
+      // The upper levels aren't cascaded down yet for this revolution
+      return 0;
+    }
+  for (Index = 0; Root + Index < WHEEL_ROOT_SIZE && Index < NextDue; Index++)
+    {
+      if (Sch->Wheel[Root + Index] != WHEEL_NIL)
+        {
+          return Index;
+        }
+    }
+  if (Index < NextDue)
+    {
+      NextDue = Index;
+    }
+#endif
+
+  return NextDue;
+}
+#endif
+
+#if SCH_CLOCK_DRIVEN || SCH_STATS || SCH_DISPATCH_BUDGET_US
+/*********************************************************************
+* Function : Sch_NowNs()
+*//**
+* \b Description:
+*
+* Utility function used to read the scheduler clock, the virtual one
+* with SCH_BACKEND_SIM.
+*
+* @return uint64_t CLOCKID time in nanoseconds.
+*
+**********************************************************************/
+static uint64_t Sch_NowNs(void)
+{
+#if SCH_SIM
+  return SimNowNs;
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCKID, &ts);
+  return (uint64_t)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+#endif
+}
+#endif
+
+/*********************************************************************
+* Function : Sch_SimRun()
+*//**
+* \b Description:
+*
+* This function is used to run the schedule for a number of ticks on the
+* virtual clock of SCH_BACKEND_SIM, as fast as the tasks run on the host:
+* there's no timer and no sleep, every Sch_Update jumps the clock to the
+* next wakeup. Each task run advances the clock by the WCET declared
+* with Sch_SetTaskWcet (or Sch_AddTaskAuto), or by the host time it
+* really took when it has none, so overruns, missed releases and late
+* dispatches happen as they would on a target that fast. The scheduler
+* is started first if it isn't yet.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: At least Ticks more ticks are processed, the trace of
+* Sch_SimTrace is written up to now.
+*
+* @param Ticks the ticks to simulate.
+*
+* @return int 0, or -1 with errno ENOSYS if SCH_BACKEND isn't
+* SCH_BACKEND_SIM.
+*
+* \b Example:
+* @code
+* Sch_Init();
+* Sch_SetTaskWcet(Sch_AddTask(control, 0, 1), 1500);
+* Sch_SimRun(24u * 3600u * 1000u / TICK); // a day
+* Sch_SimReport(stdout);
+* @endcode
+*
+* @see Sch_SimReport
+* @see Sch_SimTrace
+*
+**********************************************************************/
+int Sch_SimRun(const uint32_t Ticks)
+{
+#if SCH_SIM
+  Sch_t *Sch = &Instances[0];
+  const uint32_t End = Sch->TickNow + Ticks;
+  const uint64_t HostStart = Sim_HostNs();
+
+  if (Sch->Epoch == 0)
+    {
+      Sch_Start();
+    }
+  while ((int32_t)(End - Sch->TickNow) > 0)
+    {
+      Ctx_Update(Sch);
+    }
+  SimHostNs += Sim_HostNs() - HostStart;
+#if SCH_TRACE
+  if (SimTrace != NULL)
+    {
+      Sim_Flush(Sch, 1);
+    }
+#endif
+  return 0;
+#else
+  (void)Ticks;
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+/*********************************************************************
+* Function : Sch_SimTrace()
+*//**
+* \b Description:
+*
+* This function is used to record the whole simulated schedule to a
+* file, in the Sch_TraceDump layout with a single block: the events still
+* in the ring come first, then every later one, written out each time
+* the ring fills up. The block is brought up to date at the end of every
+* Sch_SimRun and by Sch_Deinit, which closes the file. tools/sch_trace2json
+* converts it, the times being the virtual ones.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: Path receives the trace of the simulation.
+*
+* @param Path the file to write, a previous one is closed.
+*
+* @return int 0 on success, -1 with errno set on failure, ENOSYS if
+* SCH_TRACE is 0 or SCH_BACKEND isn't SCH_BACKEND_SIM.
+*
+* \b Example:
+* @code
+* Sch_SimTrace("day.bin");
+* Sch_SimRun(24u * 3600u * 1000u / TICK);
+* @endcode
+*
+* @see Sch_SimRun
+*
+**********************************************************************/
+int Sch_SimTrace(const char *Path)
+{
+#if SCH_SIM && SCH_TRACE
+  const Sch_TraceHeader_t Header = {
+    .Magic = SCH_TRACE_MAGIC,
+    .Version = SCH_TRACE_VERSION,
+    .Cores = 1,
+    .TickUs = TICK * 1000u,
+    .Pid = getpid(),
+    .EventSize = sizeof(Sch_TraceEvent_t),
+  };
+  const uint64_t Head = atomic_load_explicit(&Instances[0].TraceHead, memory_order_relaxed);
+
+  if (SimTrace != NULL)
+    {
+      Sim_Flush(&Instances[0], 1);
+      fclose(SimTrace);
+    }
+  SimTrace = fopen(Path, "wb");
+  if (SimTrace == NULL)
+    {
+      return -1;
+    }
+  SimFlushed = Head > SCH_TRACE_SIZE ? Head - SCH_TRACE_SIZE : 0;
+  SimBlock = (Sch_TraceBlock_t){ .Core = 0, .Count = 0, .Lost = SimFlushed };
+  fwrite(&Header, sizeof(Header), 1, SimTrace);
+  fwrite(&SimBlock, sizeof(SimBlock), 1, SimTrace);
+  return ferror(SimTrace) ? -1 : 0;
+#else
+  (void)Path;
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+/*********************************************************************
+* Function : Sch_SimReport()
+*//**
+* \b Description:
+*
+* This function is used to print the utilization report of a simulation:
+* the simulated and host times, how busy the CPU was, the longest
+* dispatch round and the rounds that ended past the next wakeup, the
+* dispatch latency, then the period, WCET, runs, missed releases,
+* overruns, run times and CPU share of every task.
+*
+* PRE-CONDITION: Sch_SimRun() is called <br>
+* POST-CONDITION: None.
+*
+* @param Out where the report is printed.
+*
+* @return int 0, or -1 with errno ENOSYS if SCH_BACKEND isn't
+* SCH_BACKEND_SIM.
+*
+* @see Sch_SimRun
+*
+**********************************************************************/
+int Sch_SimReport(FILE *Out)
+{
+#if SCH_SIM
+  Sch_t *Sch = &Instances[0];
+  const uint64_t SimNs = (uint64_t)Sch->IdleStats.Ticks * NS_PER_TICK;
+  const double Span = SimNs ? (double)SimNs : 1.0;
+  const TaskConfig_t *Entry;
+  Sch_Stats_t Stats;
+  uint32_t TaskId, Word;
+  uint64_t Bits;
+
+  Sch_GetStats(&Stats);
+  fprintf(Out, "simulated %u ticks (%.3f s) in %.3f s of host time",
+          Sch->IdleStats.Ticks, (double)SimNs / 1e9, (double)SimHostNs / 1e9);
+  if (SimHostNs != 0)
+    {
+      fprintf(Out, ", %.0fx real time", (double)SimNs / (double)SimHostNs);
+    }
+  fprintf(Out, "\nbusy %.2f%%, %u wakeups, %" PRIu64 " runs, longest round %.1f us "
+          "(tick %u, %.1f%% of a tick), %" PRIu64 " late rounds\n",
+          100.0 * (double)SimBusyNs / Span, Sch->IdleStats.Wakeups, Stats.Dispatches,
+          (double)SimRoundMaxNs / 1e3, SimRoundMaxTick,
+          100.0 * (double)SimRoundMaxNs / (double)NS_PER_TICK, SimLateRounds);
+  fprintf(Out, "dispatch latency mean %.1f us max %.1f us, max backlog %u, budget cuts %" PRIu64 "\n",
+          (double)Stats.LatencyMeanNs / 1e3, (double)Stats.LatencyMaxNs / 1e3,
+          Stats.MaxBacklog, Stats.BudgetCuts);
+  fprintf(Out, "%6s %8s %9s %10s %8s %9s %9s %9s %7s\n", "ID", "PERIOD", "WCET_US",
+          "RUNS", "MISSED", "OVERRUNS", "MEAN_US", "MAX_US", "CPU%");
+  // Slots are walked directly, the ID column shows the id Sch_AddTask returned
+  for (Word = 0; Word < LIVE_WORDS; Word++)
+    {
+      for (Bits = Sch->Live[Word]; Bits != 0; Bits &= Bits - 1)
+        {
+          TaskId = Word * 64u + (uint32_t)__builtin_ctzll(Bits);
+          Entry = &Sch->Config[TaskId];
+          fprintf(Out, "%6u %8u %9u %10u %8u %9u %9.1f %9.1f %7.2f\n",
+                  Id_Make(Sch, TaskId), (uint32_t)Entry->Period, Entry->WcetUs,
+                  Entry->Stats.Runs, Entry->Missed, Entry->Stats.Overruns,
+                  Entry->Stats.Runs ? (double)Entry->Stats.TotalNs / (double)Entry->Stats.Runs / 1e3 : 0.0,
+                  (double)Entry->Stats.MaxNs / 1e3,
+                  100.0 * (double)Entry->Stats.TotalNs / Span);
+        }
+    }
+  return ferror(Out) ? -1 : 0;
+#else
+  (void)Out;
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+#if SCH_SIM
+/*********************************************************************
+* Function : Sim_HostNs()
+*//**
+* \b Description:
+* Utility function used to read the host clock, CLOCK_MONOTONIC, that
+* measures the task runs without a declared WCET.
+*
+* @return uint64_t the time in ns.
+**********************************************************************/
+static uint64_t Sim_HostNs(void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return (uint64_t)Now.tv_sec * NS_PER_SEC + (uint64_t)Now.tv_nsec;
+}
+
+/*********************************************************************
+* Function : Sim_Charge()
+*//**
+* \b Description:
+* Utility function used to advance the virtual clock by the cost of the
+* task run that just returned.
+*
+* @param CostNs the declared cost, 0 to charge the host time instead.
+* @param HostStart the host time the run started at.
+*
+* @return void
+*
+* @see Ctx_Run
+**********************************************************************/
+static void Sim_Charge(const uint64_t CostNs, const uint64_t HostStart)
+{
+  const uint64_t Charged = CostNs != 0 ? CostNs : Sim_HostNs() - HostStart;
+
+  SimNowNs += Charged;
+  SimBusyNs += Charged;
+}
+
+/*********************************************************************
+* Function : Sim_Sleep()
+*//**
+* \b Description:
+* Utility function used to end a dispatch round: its length is recorded,
+* then the virtual clock jumps to the wakeup, unless the round already
+* ran past it.
+*
+* @param Sch the scheduler instance.
+* @param Deadline the virtual time to wake up at.
+*
+* @return void
+*
+* @see Ctx_GoToSleep
+**********************************************************************/
+static void Sim_Sleep(Sch_t *Sch, const uint64_t Deadline)
+{
+  const uint64_t Round = SimNowNs - SimWakeNs;
+
+  if (Round > SimRoundMaxNs)
+    {
+      SimRoundMaxNs = Round;
+      SimRoundMaxTick = Sch->TickNow - 1;
+    }
+  if (SimNowNs <= Deadline)
+    {
+      SimNowNs = Deadline;
+    }
+  else
+    {
+      SimLateRounds++;
+    }
+  SimWakeNs = SimNowNs;
+}
+
+#if SCH_TRACE
+/*********************************************************************
+* Function : Sim_Flush()
+*//**
+* \b Description:
+* Utility function used to append the events recorded since the last
+* flush to the file of Sch_SimTrace. Past UINT32_MAX events they are
+* only counted as lost.
+*
+* @param Sch the scheduler instance.
+* @param Sync 1 to also rewrite the block header, so the file is
+* complete up to now.
+*
+* @return void
+*
+* @see Sch_SimTrace
+**********************************************************************/
+static void Sim_Flush(Sch_t *Sch, const uint8_t Sync)
+{
+  const uint64_t Head = atomic_load_explicit(&Sch->TraceHead, memory_order_relaxed);
+  uint64_t Count;
+
+  while (SimFlushed < Head)
+    {
+      // Up to the end of the ring, then from its start
+      Count = Head - SimFlushed;
+      if (Count > SCH_TRACE_SIZE - (SimFlushed & TRACE_MASK))
+        {
+          Count = SCH_TRACE_SIZE - (SimFlushed & TRACE_MASK);
+        }
+      if (Count > UINT32_MAX - SimBlock.Count)
+        {
+          Count = UINT32_MAX - SimBlock.Count;
+        }
+      if (Count == 0)
+        {
+          SimBlock.Lost += Head - SimFlushed;
+          break;
+        }
+      fwrite(&Sch->Trace[SimFlushed & TRACE_MASK], sizeof(Sch_TraceEvent_t), Count, SimTrace);
+      SimBlock.Count += (uint32_t)Count;
+      SimFlushed += Count;
+    }
+  SimFlushed = Head;
+  if (Sync)
+    {
+      fseek(SimTrace, sizeof(Sch_TraceHeader_t), SEEK_SET);
+      fwrite(&SimBlock, sizeof(SimBlock), 1, SimTrace);
+      fseek(SimTrace, 0, SEEK_END);
+      fflush(SimTrace);
+    }
+}
+#endif
+#endif
+
+/*********************************************************************
+* Function : Sch_Start()
+*//**
+* \b Description:
+*
+* This function is used to start the schedule module. 
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The scheduler starts.
+*
+* @return void
+*
+* \b Example:
+* @code
+* Sch_Init();
+* Sch_AddTask(count, 0, 10);
+* Sch_Start();
+* @endcode
+*
+* @see Sch_Init
+*
+**********************************************************************/
+void Sch_Start(void)
+{ 
+#if SCH_RT
+  Ctx_RtSetup(&Instances[0], SCH_RT_CPU);
+#endif
+  // Sch_PostEvent wakes this thread up
+  Instances[0].Thread = pthread_self();
+  Ctx_Start(&Instances[0], 0);
+}
+
+/*********************************************************************
+* Function : Ctx_Start()
+*//**
+* \b Description:
+* Utility function used to create the timer of one instance and start
+* it. The timer signal is sent to the process, or to a single thread
+* when ThreadId isn't 0.
+*
+* @param Sch the scheduler instance.
+* @param ThreadId the kernel thread id to signal, 0 for the process.
+*
+* @return void
+*
+* @see Sch_Start
+**********************************************************************/
+static void Ctx_Start(Sch_t *Sch, const pid_t ThreadId)
+{
+#if SCH_CLOCK_DRIVEN || SCH_STATS
+  /* Tick k is due at Epoch + k ticks, the first Sch_Update processes
+  the current tick right away */
+  Sch->Epoch = Sch_NowNs() - (uint64_t)Sch->TickNow * NS_PER_TICK;
+#endif
+#if SCH_SIM
+  // No timer: Ctx_GoToSleep moves the virtual clock to the wakeup
+  (void)ThreadId;
+  SimWakeNs = SimNowNs;
+#elif SCH_BACKEND == SCH_BACKEND_TIMERFD
+  (void)ThreadId;
+#if !SCH_CLOCK_DRIVEN
+  /* The tickless timer is armed one-shot by every Ctx_GoToSleep */
+  struct itimerspec its;
+  /* Start the timer, the first Sch_Update processes tick 0 right away */
+  its.it_value.tv_sec = 0;
+  its.it_value.tv_nsec = TICK * 1000000;
+  its.it_interval = its.it_value;
+  Sch->PendingTicks = 1;
+  if (timerfd_settime(Sch->TimerFd, 0, &its, NULL) == -1)
+    {
+      perror("timerfd_settime");
+      exit(EXIT_FAILURE);
+    }
+#endif
+#else
+  struct sigevent sev = { 0 };
+
+  /* Create the timer */
+  sev.sigev_signo = TIMER_SIG;
+  sev.sigev_value.sival_ptr = Sch;
+  if (ThreadId != 0)
+    {
+      sev.sigev_notify = SIGEV_THREAD_ID;
+      sev.sigev_notify_thread_id = ThreadId;
+    }
+  else
+    {
+      sev.sigev_notify = SIGEV_SIGNAL;
+    }
+  if (timer_create(CLOCKID, &sev, &Sch->Timer) == -1)
+    {
+      perror("timer_create");
+      exit(EXIT_FAILURE);
+    }
+  Sch->HasTimer = 1;
+
+#if !SCH_CLOCK_DRIVEN
+  /* The tickless timer is armed one-shot by every Ctx_GoToSleep */
+  struct itimerspec its;    
+  /* Start the timer */
+  its.it_value.tv_sec = 0;
+  its.it_value.tv_nsec = TICK * 1000000;
+  its.it_interval.tv_sec = its.it_value.tv_sec;
+  its.it_interval.tv_nsec = its.it_value.tv_nsec;
+
+  if (timer_settime(Sch->Timer, 0, &its, NULL) == -1)
+    {
+      perror("timer_settime");
+      exit(EXIT_FAILURE);
+    }
+#endif
+#endif
+}
+
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
+/*********************************************************************
+* Function : Ctx_Open()
+*//**
+* \b Description:
+* Utility function used to create the timerfd, the wake eventfd and the
+* epoll instance of one scheduler instance.
+*
+* @param Sch the scheduler instance.
+*
+* @return void
+*
+* @see Sch_Init
+**********************************************************************/
+static void Ctx_Open(Sch_t *Sch)
+{
+  struct epoll_event Event = { 0 };
+
+  Sch->TimerFd = timerfd_create(CLOCKID, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (Sch->TimerFd == -1)
+    {
+      perror("timerfd_create");
+      exit(EXIT_FAILURE);
+    }
+  Sch->WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (Sch->WakeFd == -1)
+    {
+      perror("eventfd");
+      exit(EXIT_FAILURE);
+    }
+  Sch->EpollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (Sch->EpollFd == -1)
+    {
+      perror("epoll_create1");
+      exit(EXIT_FAILURE);
+    }
+
+  Event.events = EPOLLIN;
+  Event.data.u64 = FD_KEY_TIMER;
+  if (epoll_ctl(Sch->EpollFd, EPOLL_CTL_ADD, Sch->TimerFd, &Event) == -1)
+    {
+      perror("epoll_ctl");
+      exit(EXIT_FAILURE);
+    }
+  Event.data.u64 = FD_KEY_WAKE;
+  if (epoll_ctl(Sch->EpollFd, EPOLL_CTL_ADD, Sch->WakeFd, &Event) == -1)
+    {
+      perror("epoll_ctl");
+      exit(EXIT_FAILURE);
+    }
+
+  Sch->PendingTicks = 0;
+  Sch->HasTimer = 1;
+}
+
+/*********************************************************************
+* Function : Ctx_HandleEvents()
+*//**
+* \b Description:
+* Utility function used to serve the descriptors epoll_wait reported:
+* timer expirations are added to PendingTicks, wake events are
+* consumed and application descriptors are passed to their handler.
+*
+* @param Sch the scheduler instance.
+* @param Events the ready events.
+* @param Count the number of ready events.
+*
+* @return void
+*
+* @see Ctx_GoToSleep
+**********************************************************************/
+static void Ctx_HandleEvents(Sch_t *Sch, struct epoll_event *Events, int Count)
+{
+  uint64_t Value;
+  FdEntry_t *Entry;
+  int Index;
+
+  for (Index = 0; Index < Count; Index++)
+    {
+      switch (Events[Index].data.u64)
+        {
+        case FD_KEY_TIMER:
+          if (read(Sch->TimerFd, &Value, sizeof(Value)) == sizeof(Value))
+            {
+              Sch->PendingTicks += Value;
+            }
+          break;
+        case FD_KEY_WAKE:
+          if (read(Sch->WakeFd, &Value, sizeof(Value)) != sizeof(Value))
+            {
+              // Already consumed, nothing to do
+            }
+          break;
+        default:
+          Entry = &Sch->Fds[Events[Index].data.u64 - FD_KEY_APP];
+          // A handler may have deleted a descriptor of this batch
+          if (Entry->Handler != NULL)
+            {
+              Entry->Handler(Entry->Fd, Events[Index].events, Entry->Arg);
+            }
+          break;
+        }
+    }
+}
+
+/*********************************************************************
+* Function : Sch_AddFd()
+*//**
+* \b Description:
+*
+* This function is used to make the scheduler loop also wait on an
+* application descriptor (a socket, a pipe...). Handler is called from
+* Sch_Update, between ticks, each time Fd is ready for Events.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* PRE-CONDITION: SCH_BACKEND is SCH_BACKEND_TIMERFD <br>
+* POST-CONDITION: Fd is watched by the loop of instance 0.
+*
+* @param Fd the descriptor to watch.
+* @param Events the epoll events to wait for, e.g. EPOLLIN.
+* @param Handler called with Fd, the ready events and Arg.
+* @param Arg passed to Handler.
+*
+* @return int 0 on success, -1 if the descriptor table is full or
+* epoll refused Fd.
+*
+* \b Example:
+* @code
+* Sch_Init();
+* Sch_AddFd(Socket, EPOLLIN, OnSocket, &Connection);
+* Sch_Start();
+* @endcode
+*
+* @see Sch_DeleteFd
+*
+**********************************************************************/
+int Sch_AddFd(const int Fd, const uint32_t Events, Sch_FdHandler_t Handler,
+      void *Arg)
+{
+  Sch_t *Sch = &Instances[0];
+  struct epoll_event Event = { 0 };
+  uint32_t Index = 0;
+
+  while (Index < SCH_MAX_FDS && Sch->Fds[Index].Handler != NULL)
+    {
+      Index++;
+    }
+  if (Index == SCH_MAX_FDS || Handler == NULL)
+    {
+      return -1;
+    }
+
+  Event.events = Events;
+  Event.data.u64 = FD_KEY_APP + Index;
+  if (epoll_ctl(Sch->EpollFd, EPOLL_CTL_ADD, Fd, &Event) == -1)
+    {
+      return -1;
+    }
+  Sch->Fds[Index].Fd = Fd;
+  Sch->Fds[Index].Handler = Handler;
+  Sch->Fds[Index].Arg = Arg;
+  return 0;
+}
+
+/*********************************************************************
+* Function : Sch_DeleteFd()
+*//**
+* \b Description:
+*
+* This function is used to stop waiting on an application descriptor.
+* It may be called from the descriptor handler itself.
+*
+* PRE-CONDITION: Sch_AddFd(Fd, ...) is called <br>
+* POST-CONDITION: Fd isn't watched anymore.
+*
+* @param Fd the descriptor given to Sch_AddFd.
+*
+* @return void
+*
+* @see Sch_AddFd
+*
+**********************************************************************/
+void Sch_DeleteFd(const int Fd)
+{
+  Sch_t *Sch = &Instances[0];
+  uint32_t Index;
+
+  for (Index = 0; Index < SCH_MAX_FDS; Index++)
+    {
+      if (Sch->Fds[Index].Handler != NULL && Sch->Fds[Index].Fd == Fd)
+        {
+          epoll_ctl(Sch->EpollFd, EPOLL_CTL_DEL, Fd, NULL);
+          Sch->Fds[Index].Handler = NULL;
+        }
+    }
+}
+#endif
+
+/*********************************************************************
+* Function : Sch_StartCores()
+*//**
+* \b Description:
+*
+* This function is used to run the scheduler instances of the first
+* Cores cores, each on its own worker thread pinned to the CPU
+* SCH_CORE_CPU(Core), with its own timer signalling only that thread.
+* The instances share nothing, so the tick path takes no lock.
+* It returns right away, the calling thread is free for other work.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* PRE-CONDITION: Sch_Start() isn't called <br>
+* POST-CONDITION: The worker threads run their task sets.
+*
+* @param Cores the number of cores to run, <= SCH_MAX_CORES
+*
+* @return void
+*
+* \b Example:
+* @code
+* Sch_Init();
+* Sch_AddTaskOnCore(0, count0, 0, 10);
+* Sch_AddTaskOnCore(1, count1, 0, 10);
+* Sch_StartCores(2);
+* @endcode
+*
+* @see Sch_AddTaskOnCore
+* @see Sch_StopCores
+*
+**********************************************************************/
+void Sch_StartCores(const uint32_t Cores)
+{
+  pthread_attr_t Attr;
+  cpu_set_t Cpus;
+  uint32_t Core;
+  int Error;
+
+  for (Core = 0; Core < Cores && Core < SCH_MAX_CORES; Core++)
+    {
+      pthread_attr_init(&Attr);
+      CPU_ZERO(&Cpus);
+      CPU_SET(SCH_CORE_CPU(Core), &Cpus);
+      pthread_attr_setaffinity_np(&Attr, sizeof(Cpus), &Cpus);
+      Error = pthread_create(&Instances[Core].Thread, &Attr, Core_Main,
+                             &Instances[Core]);
+      pthread_attr_destroy(&Attr);
+      if (Error != 0)
+        {
+          fprintf(stderr, "pthread_create: core %u: error %d\n",
+                  (unsigned)Core, Error);
+          exit(EXIT_FAILURE);
+        }
+      CoresStarted++;
+    }
+}
+
+/*********************************************************************
+* Function : Sch_StopCores()
+*//**
+* \b Description:
+*
+* This function is used to stop the worker threads started by
+* Sch_StartCores. Each one finishes its current round and returns,
+* then the timer of its instance is stopped.
+*
+* PRE-CONDITION: Sch_StartCores() is called <br>
+* POST-CONDITION: No worker thread is running.
+*
+* @return void
+*
+* @see Sch_StartCores
+*
+**********************************************************************/
+void Sch_StopCores(void)
+{
+  uint32_t Core;
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
+  const struct itimerspec Disarm = { 0 };
+#endif
+
+  atomic_store(&CoresStop, 1);
+  for (Core = 0; Core < CoresStarted; Core++)
+    {
+      // Wake the worker up instead of waiting for its next tick
+      Ctx_Wake(&Instances[Core]);
+      pthread_join(Instances[Core].Thread, NULL);
+      // Its timer must not fire for a thread that's gone, Sch_StartCores
+      // arms it again
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
+      timerfd_settime(Instances[Core].TimerFd, 0, &Disarm, NULL);
+#elif SCH_BACKEND == SCH_BACKEND_SIGNAL
+      if (Instances[Core].HasTimer)
+        {
+          timer_delete(Instances[Core].Timer);
+          Instances[Core].HasTimer = 0;
+        }
+#endif
+    }
+  CoresStarted = 0;
+  atomic_store(&CoresStop, 0);
+}
+
+/*********************************************************************
+* Function : Core_Main()
+*//**
+* \b Description:
+*
+* Utility function: the body of a worker thread. It starts the timer of
+* its instance then runs it until Sch_StopCores.
+*
+* @param Arg the scheduler instance of the thread.
+*
+* @return void* NULL
+*
+* @see Sch_StartCores
+**********************************************************************/
+static void *Core_Main(void *Arg)
+{
+  Sch_t *Sch = Arg;
+
+#if SCH_RT
+  Ctx_RtSetup(Sch, SCH_CORE_CPU(Sch - Instances));
+#endif
+  Ctx_Start(Sch, (pid_t)syscall(SYS_gettid));
+  while (atomic_load_explicit(&CoresStop, memory_order_relaxed) == 0)
+    {
+      Ctx_Update(Sch);
+    }
+
+  return NULL;
+}
+
+/*********************************************************************
+* Function : Sch_SetTaskAffinity()
+*//**
+* \b Description:
+*
+* This function is used to pin a task to the core it was added on.
+* A pinned task is never pushed to the work-stealing deque: its
+* instances run serially, one per round, like in the serial dispatch.
+* Use it for tasks that aren't safe to run concurrently with themselves.
+* It has no effect with the serial dispatch, where every task is serial.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* PRE-CONDITION: The worker threads aren't running <br>
+* POST-CONDITION: The task affinity is set.
+*
+* @param Core the core index the task was added on.
+* @param TaskId The id returned by Sch_AddTaskOnCore.
+* @param Pinned 1 to pin the task, 0 to let idle workers steal it.
+*
+* @return void
+*
+* \b Example:
+* @code
+* Sch_Init();
+* Sch_TaskId_t taskId = Sch_AddTaskOnCore(0, log, 0, 10);
+* Sch_SetTaskAffinity(0, taskId, 1);
+* @endcode
+*
+* @see Sch_AddTaskOnCore
+*
+**********************************************************************/
+void Sch_SetTaskAffinity(const uint32_t Core, const Sch_TaskId_t TaskId,
+      const uint8_t Pinned)
+{
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+  uint32_t Slot;
+
+  if (Core >= SCH_MAX_CORES)
+    {
+      return;
+    }
+  Slot = Id_Slot(&Instances[Core], TaskId);
+  if (Slot < SCH_MAX_TASKS)
+    {
+      Instances[Core].Config[Slot].Pinned = Pinned;
+    }
+#endif
+}
+
+#if SCH_DISPATCH == SCH_DISPATCH_STEALING
+
+/*********************************************************************
+* Function : Ctx_Steal()
+*//**
+* \b Description:
+*
+* Utility function used by an idle worker to run the task instances
+* queued on the other workers' deques until they're all empty.
+*
+* @param Sch the scheduler instance of the idle worker.
+*
+* @return void
+*
+* @see Ctx_Dispatch
+**********************************************************************/
+static void Ctx_Steal(Sch_t *Sch)
+{
+  TaskConfig_t *Entry;
+  uint32_t Victim;
+  uint8_t Busy;
+
+  do
+    {
+      Busy = 0;
+      for (Victim = 0; Victim < SCH_MAX_CORES; Victim++)
+        {
+          if (&Instances[Victim] == Sch)
+            {
+              continue;
+            }
+          switch (Deque_Steal(&Instances[Victim].Deque, &Entry))
+            {
+            case DEQUE_OK:
+              Ctx_Run(Sch, Entry);
+              // The owner may free the slot of a deleted task from now on
+              atomic_fetch_sub_explicit(&Entry->InFlight, 1, memory_order_release);
+              Busy = 1;
+              break;
+            case DEQUE_ABORT:
+              Busy = 1;
+              break;
+            default:
+              break;
+            }
+        }
+    }
+  while (Busy);
+}
+
+/*********************************************************************
+* Function : Ctx_Kick()
+*//**
+* \b Description:
+*
+* Utility function used to wake the other worker threads up so that
+* they steal from the deque of Sch. The kick isn't counted as a tick.
+*
+* @param Sch the scheduler instance with a backlog.
+*
+* @return void
+*
+* @see Ctx_GoToSleep
+**********************************************************************/
+static void Ctx_Kick(Sch_t *Sch)
+{
+  uint32_t Core;
+
+  for (Core = 0; Core < CoresStarted; Core++)
+    {
+      if (&Instances[Core] != Sch)
+        {
+          Ctx_Wake(&Instances[Core]);
+        }
+    }
+}
+
+/*********************************************************************
+* Function : Deque_Push()
+*//**
+* \b Description:
+*
+* Utility function used by the owner to push an entry at the bottom.
+*
+* @param Deque the owner deque.
+* @param Entry the due task.
+*
+* @return uint8_t 1 if pushed, 0 if the deque is full.
+*
+**********************************************************************/
+static uint8_t Deque_Push(Deque_t *Deque, TaskConfig_t *Entry)
+{
+  int64_t Bottom = atomic_load_explicit(&Deque->Bottom, memory_order_relaxed);
+  int64_t Top = atomic_load_explicit(&Deque->Top, memory_order_acquire);
+
+  if (Bottom - Top >= SCH_DEQUE_SIZE)
+    {
+      return 0;
+    }
+  atomic_store_explicit(&Deque->Buffer[Bottom & DEQUE_MASK], Entry,
+                        memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&Deque->Bottom, Bottom + 1, memory_order_relaxed);
+  return 1;
+}
+
+/*********************************************************************
+* Function : Deque_Take()
+*//**
+* \b Description:
+*
+* Utility function used by the owner to take the last pushed entry.
+*
+* @param Deque the owner deque.
+* @param Entry where the entry is returned, NULL unless DEQUE_OK.
+*
+* @return DequeStatus_t DEQUE_OK, DEQUE_EMPTY, or DEQUE_ABORT when a
+* thief took the last entry first.
+*
+**********************************************************************/
+static DequeStatus_t Deque_Take(Deque_t *Deque, TaskConfig_t **Entry)
+{
+  int64_t Bottom = atomic_load_explicit(&Deque->Bottom, memory_order_relaxed) - 1;
+  int64_t Top;
+  DequeStatus_t Status = DEQUE_OK;
+
+  *Entry = NULL;
+  atomic_store_explicit(&Deque->Bottom, Bottom, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  Top = atomic_load_explicit(&Deque->Top, memory_order_relaxed);
+
+  if (Top > Bottom)
+    {
+      // Empty, restore the bottom
+      atomic_store_explicit(&Deque->Bottom, Bottom + 1, memory_order_relaxed);
+      return DEQUE_EMPTY;
+    }
+
+  *Entry = atomic_load_explicit(&Deque->Buffer[Bottom & DEQUE_MASK],
+                                memory_order_relaxed);
+  if (Top == Bottom)
+    {
+      // The last entry, race the thieves for it
+      if (!atomic_compare_exchange_strong_explicit(&Deque->Top, &Top, Top + 1,
+                                                   memory_order_seq_cst,
+                                                   memory_order_relaxed))
+        {
+          *Entry = NULL;
+          Status = DEQUE_ABORT;
+        }
+      atomic_store_explicit(&Deque->Bottom, Bottom + 1, memory_order_relaxed);
+    }
+  return Status;
+}
+
+/*********************************************************************
+* Function : Deque_Steal()
+*//**
+* \b Description:
+*
+* Utility function used by any thread to steal the oldest entry.
+*
+* @param Deque the victim deque.
+* @param Entry where the entry is returned, valid on DEQUE_OK only.
+*
+* @return DequeStatus_t DEQUE_OK, DEQUE_EMPTY, or DEQUE_ABORT when
+* another thread won the entry.
+*
+**********************************************************************/
+static DequeStatus_t Deque_Steal(Deque_t *Deque, TaskConfig_t **Entry)
+{
+  int64_t Top = atomic_load_explicit(&Deque->Top, memory_order_acquire);
+  int64_t Bottom;
+
+  atomic_thread_fence(memory_order_seq_cst);
+  Bottom = atomic_load_explicit(&Deque->Bottom, memory_order_acquire);
+  if (Top >= Bottom)
+    {
+      return DEQUE_EMPTY;
+    }
+
+  *Entry = atomic_load_explicit(&Deque->Buffer[Top & DEQUE_MASK],
+                                memory_order_relaxed);
+  if (!atomic_compare_exchange_strong_explicit(&Deque->Top, &Top, Top + 1,
+                                               memory_order_seq_cst,
+                                               memory_order_relaxed))
+    {
+      return DEQUE_ABORT;
+    }
+  return DEQUE_OK;
+}
+#endif
+
+/*********************************************************************
+* Function : Ctx_Wake()
+*//**
+* \b Description:
+*
+* Utility function used to wake the worker thread of an instance up
+* from its sleep, without it being counted as a tick.
+*
+* @param Sch the scheduler instance run by a worker thread.
+*
+* @return void
+*
+* @see Sch_StopCores
+**********************************************************************/
+static void Ctx_Wake(Sch_t *Sch)
+{
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
+  uint64_t One = 1;
+
+  if (write(Sch->WakeFd, &One, sizeof(One)) != sizeof(One))
+    {
+      // The counter is already non-zero, the thread will wake up anyway
+    }
+#elif SCH_SIM
+  // The simulated instance never waits
+  (void)Sch;
+#else
+  pthread_kill(Sch->Thread, TIMER_SIG);
+#endif
+}
+
+/*********************************************************************
+* Function : Sch_GetRtReport()
+*//**
+* \b Description:
+*
+* This function reports what the real-time start path of an instance
+* got, so a deployment can check it really runs with RT behaviour. The
+* same outcome is printed on stderr when the instance starts.
+*
+* PRE-CONDITION: Sch_Start() or Sch_StartCores() is called <br>
+* POST-CONDITION: Report holds the outcome of every step, all
+* SCH_RT_NOT_RUN if SCH_RT is 0 or the instance isn't started.
+*
+* @param Core the instance index, 0 for Sch_Start.
+* @param Report where the outcome is copied to.
+*
+* @return void
+*
+* \b Example:
+* @code
+* Sch_RtReport_t Report;
+* Sch_Start();
+* Sch_GetRtReport(0, &Report);
+* if (Report.Policy != SCH_RT_OK || Report.MemLock != SCH_RT_OK)
+*   {
+*     fprintf(stderr, "running without real-time guarantees\n");
+*   }
+* @endcode
+*
+**********************************************************************/
+void Sch_GetRtReport(const uint32_t Core, Sch_RtReport_t *Report)
+{
+  *Report = (Sch_RtReport_t){ 0 };
+#if SCH_RT
+  if (Core < SCH_MAX_CORES)
+    {
+      *Report = Instances[Core].RtReport;
+    }
+#else
+  (void)Core;
+#endif
+}
+
+#if SCH_RT
+/*********************************************************************
+* Function : Ctx_RtSetup()
+*//**
+* \b Description:
+* Utility function used to make the calling thread real-time before an
+* instance starts: SCHED_FIFO, CPU affinity, locked and prefaulted
+* memory, then checks the clock resolution. A failed step is reported
+* and skipped, it doesn't stop the scheduler.
+*
+* @param Sch the scheduler instance run by the calling thread.
+* @param Cpu the CPU to pin the thread to, -1 to leave it as is.
+*
+* @return void
+*
+* @see Sch_Start
+**********************************************************************/
+static void Ctx_RtSetup(Sch_t *Sch, const int Cpu)
+{
+  Sch_RtReport_t *Report = &Sch->RtReport;
+  uint32_t Core = Sch - Instances;
+  struct sched_param Param = { .sched_priority = SCH_RT_PRIORITY };
+  struct timespec Res;
+  cpu_set_t Cpus;
+
+  *Report = (Sch_RtReport_t){ 0 };
+
+  if (Cpu >= 0)
+    {
+      CPU_ZERO(&Cpus);
+      CPU_SET(Cpu, &Cpus);
+      Report->Affinity = Rt_Report(Core, "cpu affinity",
+          pthread_setaffinity_np(pthread_self(), sizeof(Cpus), &Cpus));
+    }
+
+  Report->Policy = Rt_Report(Core, "SCHED_FIFO",
+      pthread_setschedparam(pthread_self(), SCHED_FIFO, &Param));
+
+  // Process wide, every instance reports it for its own deployment check
+  Report->MemLock = Rt_Report(Core, "mlockall",
+      mlockall(MCL_CURRENT | MCL_FUTURE) == -1 ? errno : 0);
+
+  Rt_Prefault();
+  Report->Prefault = Rt_Report(Core, "stack prefault", 0);
+
+  clock_getres(CLOCKID, &Res);
+  Report->ClockResNs = (uint64_t)Res.tv_sec * NS_PER_SEC + Res.tv_nsec;
+  Report->ClockRes = Rt_Report(Core, "clock resolution",
+      Report->ClockResNs <= SCH_RT_MAX_CLOCK_RES ? 0 : ERANGE);
+}
+
+/*********************************************************************
+* Function : Rt_Report()
+*//**
+* \b Description:
+* Utility function used to print the outcome of one real-time step.
+*
+* @param Core the instance index.
+* @param Step the step name.
+* @param Error 0 on success, else the errno of the failure.
+*
+* @return Sch_RtStatus_t SCH_RT_OK or SCH_RT_FAILED.
+**********************************************************************/
+static Sch_RtStatus_t Rt_Report(const uint32_t Core, const char *Step, const int Error)
+{
+  if (Error != 0)
+    {
+      fprintf(stderr, "sch core %u: %s: failed: %s\n",
+              (unsigned)Core, Step, strerror(Error));
+      return SCH_RT_FAILED;
+    }
+  fprintf(stderr, "sch core %u: %s: ok\n", (unsigned)Core, Step);
+  return SCH_RT_OK;
+}
+
+/*********************************************************************
+* Function : Rt_Prefault()
+*//**
+* \b Description:
+* Utility function used to touch SCH_RT_PREFAULT_STACK bytes of stack
+* below the caller, so once memory is locked the stack the tasks use
+* is already mapped.
+*
+* @return void
+**********************************************************************/
+static __attribute__((noinline)) void Rt_Prefault(void)
+{
+  uint8_t Stack[SCH_RT_PREFAULT_STACK];
+
+  memset(Stack, 0, sizeof(Stack));
+  // Keep the compiler from dropping the dead stores
+  __asm__ volatile ("" : : "r" (Stack) : "memory");
+}
+#endif
+
+#if SCH_BACKEND == SCH_BACKEND_SIGNAL
+/*********************************************************************
+* Function : TimerHandler()
+*//**
+* \b Description:
+*
+* Utility function: a handler for the realtime Timer overrunning. It uses SIGRTMIN signal.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* PRE-CONDITION: SIGRTMIN is binded to this handler
+*
+* POST-CONDITION: A scheduler tick happens.
+*
+* @param sig SIGRTMIN signal number
+* @param si information from the signal sender
+* @param uc the context of signal
+*
+* @return void
+*
+* @see Sch_Init
+**********************************************************************/
+static void
+TimerHandler(int sig, siginfo_t *si, void *uc)
+{
+  //Do nothing, just wake up the CPU
+  if (si->si_code == SI_TIMER)
+    {
+      TimerFired = 1;
+    }
+}
+#endif
+
+/**
+ * @brief Deinitialize the scheduler module: the timers of every
+ * instance are freed, and the statistics segment is removed.
  */
-/************************* END OF FILE ********************************/
 void 
 Sch_Deinit(void) {
-  timer_delete(timerid);
+  uint32_t Core;
+
+  for (Core = 0; Core < SCH_MAX_CORES; Core++)
+    {
+      if (Instances[Core].HasTimer)
+        {
+#if SCH_BACKEND == SCH_BACKEND_TIMERFD
+          close(Instances[Core].EpollFd);
+          close(Instances[Core].WakeFd);
+          close(Instances[Core].TimerFd);
+#else
+          timer_delete(Instances[Core].Timer);
+#endif
+          Instances[Core].HasTimer = 0;
+        }
+    }
+#if SCH_SIM && SCH_TRACE
+  if (SimTrace != NULL)
+    {
+      Sim_Flush(&Instances[0], 1);
+      fclose(SimTrace);
+      SimTrace = NULL;
+    }
+#endif
+#if SCH_SHM
+  if (Shm != NULL)
+    {
+      munmap(Shm, ShmSize);
+      shm_unlink(ShmName);
+      Shm = NULL;
+    }
+#endif
 }
 /************************* END OF FILE ********************************/
@@ -16,19 +16,178 @@
 * Includes
 **********************************************************************/
 #include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "sch_cfg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 /**********************************************************************
 * Module Preprocessor Constants
 **********************************************************************/
 #define TIMER_SIG SIGRTMIN
+/* Returned by Sch_AddTask when the task can't be added */
+#define SCH_NO_TASK ((Sch_TaskId_t)~(Sch_TaskId_t)0)
+/**********************************************************************
+* Typedefs
+**********************************************************************/
+/**
+* A task handle, returned by Sch_AddTask
+*/
+typedef SCH_TASK_ID_TYPE Sch_TaskId_t;
+
+/**
+* A count of ticks: task delays, periods and pending runs
+*/
+typedef SCH_TICK_TYPE Sch_Tick_t;
+
+/**
+* What happens to the releases of a task that couldn't run in time,
+* i.e. that come while the task still has a pending run.
+*/
+typedef enum
+{
+  SCH_MISS_DEFER, /*< One pending run per dispatch, the rest wait for the next ticks (Sch_AddTask) */
+  SCH_MISS_CATCH_UP, /*< Every pending run is dispatched back to back */
+  SCH_MISS_SKIP /*< At most one run stays pending, the others are dropped */
+} Sch_MissPolicy_t;
+
+/**
+* A batch task: called once with the contexts of Count of its due
+* instances, Count <= SCH_BATCH_MAX.
+*/
+typedef void (*Sch_BatchTask_t)(void **Ctx, uint32_t Count);
+
+/**
+* A bump allocator over a caller-provided buffer, e.g. to lay out the
+* contexts of many Sch_AddTaskCtx tasks next to each other.
+*/
+typedef struct
+{
+  uint8_t *Base; /*< The start of the buffer */
+  size_t Size; /*< The buffer size in bytes */
+  size_t Used; /*< The bytes handed out so far, alignment included */
+} Sch_Arena_t;
+
+/**
+* Idle counters: the ticks processed and the wakeups it took.
+*/
+typedef struct
+{
+  uint32_t Ticks; /*< Ticks processed since Sch_Init */
+  uint32_t Wakeups; /*< Times the scheduler woke up from sleep */
+} Sch_IdleStats_t;
+
+/**
+* The run time statistics of one task (SCH_STATS only).
+*/
+typedef struct
+{
+  uint32_t Runs; /*< Times the task ran */
+  uint32_t Overruns; /*< Runs longer than a tick */
+  uint64_t MinNs; /*< Shortest run */
+  uint64_t MaxNs; /*< Longest run */
+  uint64_t MeanNs; /*< Mean run, filled by Sch_GetTaskStats */
+  uint64_t TotalNs; /*< Sum of all the runs */
+  uint32_t Histogram[SCH_STATS_BUCKETS]; /*< Runs per log2(us) bucket */
+} Sch_TaskStats_t;
+
+/**
+* The dispatch statistics of one scheduler instance (SCH_STATS only).
+*/
+typedef struct
+{
+  uint64_t Dispatches; /*< Task runs started by the instance */
+  uint64_t LatencyMinNs; /*< Shortest tick-to-dispatch latency */
+  uint64_t LatencyMaxNs; /*< Longest tick-to-dispatch latency */
+  uint64_t LatencyMeanNs; /*< Mean latency, filled by Sch_GetStats */
+  uint64_t LatencyTotalNs; /*< Sum of all the latencies */
+  uint64_t LatencySamples; /*< Runs whose latency was measured, with a tick time to refer to */
+  uint64_t Backlog; /*< Sum of the runs still pending behind a dispatched one */
+  uint32_t MaxBacklog; /*< The largest RunMe seen at dispatch time */
+  uint64_t BudgetCuts; /*< Rounds stopped by SCH_DISPATCH_BUDGET_US */
+} Sch_Stats_t;
+
+/**
+* The outcome of one real-time start step (SCH_RT only).
+*/
+typedef enum
+{
+  SCH_RT_NOT_RUN, /*< The step wasn't asked for */
+  SCH_RT_OK, /*< The step succeeded */
+  SCH_RT_FAILED /*< The step failed, the scheduler runs without it */
+} Sch_RtStatus_t;
+
+/**
+* What the real-time start path of an instance got.
+*/
+typedef struct
+{
+  Sch_RtStatus_t Policy; /*< SCHED_FIFO at SCH_RT_PRIORITY */
+  Sch_RtStatus_t Affinity; /*< Pinned to its CPU */
+  Sch_RtStatus_t MemLock; /*< mlockall(MCL_CURRENT | MCL_FUTURE) */
+  Sch_RtStatus_t Prefault; /*< SCH_RT_PREFAULT_STACK bytes of stack touched */
+  Sch_RtStatus_t ClockRes; /*< Resolution <= SCH_RT_MAX_CLOCK_RES */
+  uint64_t ClockResNs; /*< The CLOCK_MONOTONIC resolution */
+} Sch_RtReport_t;
+
+/**
+* Called by the scheduler loop when an application descriptor is ready
+* (timerfd backend only), with the descriptor, its ready epoll events and
+* the argument given to Sch_AddFd.
+*/
+typedef void (*Sch_FdHandler_t)(int Fd, uint32_t Events, void *Arg);
 /**********************************************************************
 * Function Prototypes
 **********************************************************************/
 void Sch_Init(void);
 void Sch_Deinit(void);
-uint8_t Sch_AddTask(void (*Task) (void), const uint32_t Delay, const uint32_t Interval);
-void Sch_DeleteTask(const uint8_t TaskId);
+Sch_TaskId_t Sch_AddTask(void (*Task) (void), const Sch_Tick_t Delay, const Sch_Tick_t Interval);
+Sch_TaskId_t Sch_AddTaskWithPolicy(void (*Task) (void), const Sch_Tick_t Delay, const Sch_Tick_t Interval, const Sch_MissPolicy_t Policy);
+Sch_TaskId_t Sch_AddTaskCtx(void (*Task) (void *Ctx), void *Ctx, const Sch_Tick_t Delay, const Sch_Tick_t Interval);
+Sch_TaskId_t Sch_AddTaskBatch(Sch_BatchTask_t Task, void *Ctx, const Sch_Tick_t Delay, const Sch_Tick_t Interval);
+void Sch_ArenaInit(Sch_Arena_t *Arena, void *Buffer, const size_t Size);
+void *Sch_ArenaAlloc(Sch_Arena_t *Arena, const size_t Size);
+Sch_TaskId_t Sch_AddTaskAuto(void (*Task) (void), const Sch_Tick_t Interval, const uint32_t WcetUs);
+void Sch_Rebalance(void);
+int Sch_SetTaskPriority(const Sch_TaskId_t TaskId, const uint8_t Priority);
+int Sch_SetTaskWcet(const Sch_TaskId_t TaskId, const uint32_t WcetUs);
+Sch_TaskId_t Sch_AddEventTask(void (*Task) (void));
+int Sch_PostEvent(const Sch_TaskId_t TaskId);
+uint32_t Sch_GetPeakLoad(void);
+void Sch_DeleteTask(const Sch_TaskId_t TaskId);
+Sch_TaskId_t Sch_PostAddTask(void (*Task) (void), const Sch_Tick_t Delay, const Sch_Tick_t Interval);
+int Sch_PostDeleteTask(const Sch_TaskId_t TaskId);
+uint32_t Sch_GetMissedReleases(const Sch_TaskId_t TaskId);
+uint64_t Sch_GetNextRelease(const Sch_TaskId_t TaskId);
 void Sch_Start(void);
 void Sch_Update(void);
+void Sch_Tick(void);
+void Sch_DispatchTasks(void);
+void Sch_Advance(const uint32_t Ticks);
+void Sch_GetIdleStats(Sch_IdleStats_t *Stats);
+Sch_TaskId_t Sch_AddTaskOnCore(const uint32_t Core, void (*Task) (void), const Sch_Tick_t Delay, const Sch_Tick_t Interval);
+void Sch_DeleteTaskOnCore(const uint32_t Core, const Sch_TaskId_t TaskId);
+void Sch_StartCores(const uint32_t Cores);
+void Sch_StopCores(void);
+int Sch_AddFd(const int Fd, const uint32_t Events, Sch_FdHandler_t Handler, void *Arg);
+void Sch_DeleteFd(const int Fd);
+int Sch_GetTaskStats(const Sch_TaskId_t TaskId, Sch_TaskStats_t *Stats);
+int Sch_GetTaskStatsOnCore(const uint32_t Core, const Sch_TaskId_t TaskId, Sch_TaskStats_t *Stats);
+void Sch_GetStats(Sch_Stats_t *Stats);
+void Sch_GetStatsOnCore(const uint32_t Core, Sch_Stats_t *Stats);
+int Sch_ShmOpen(const char *Name);
+int Sch_TraceDump(const char *Path);
+int Sch_SimRun(const uint32_t Ticks);
+int Sch_SimTrace(const char *Path);
+int Sch_SimReport(FILE *Out);
+void Sch_GetRtReport(const uint32_t Core, Sch_RtReport_t *Report);
+void Sch_SetTaskAffinity(const uint32_t Core, const Sch_TaskId_t TaskId, const uint8_t Pinned);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* end SCH_H */
 /************************* END OF FILE ********************************/
@@ -0,0 +1,283 @@
+/**
+ * @file sch.hpp
+ * @author Mohamed Hassanin
+ * @brief Header only C++17 front end of the cooperative scheduler: the
+ *  task set is a compile-time list of Sch::Task types, so Update and
+ *  Dispatch are unrolled per task and every task body can be inlined.
+ *  The table is checked at compile time (offsets, tick utilization)
+ *  and is driven by the C scheduler as one task of period 1.
+ * @version 0.1
+ * @date 2021-02-14
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#ifndef SCH_HPP
+#define SCH_HPP
+/**********************************************************************
+* Includes
+**********************************************************************/
+#include <stddef.h>
+#include <utility>
+#include "sch.h"
+#include "sch_cfg.h"
+/**********************************************************************
+* Module Preprocessor Constants
+**********************************************************************/
+/*< The tick length the utilization is checked against, in us */
+#define SCH_TICK_US ((uint64_t)TICK * 1000u)
+
+namespace Sch
+{
+/**********************************************************************
+* Typedefs
+**********************************************************************/
+/**
+* One task of a compile-time table: its function, period and delay in
+* ticks as Sch_AddTask takes them, and its worst case run time in us
+* (0 if unknown) for the utilization checks.
+*/
+template <void (*Function)(void), Sch_Tick_t Period, Sch_Tick_t Delay = 0,
+          uint32_t WcetUs = 0>
+struct Task
+{
+  static_assert(Period > 0, "Sch::Task: the period must be > 0");
+  static_assert(Delay < Period, "Sch::Task: the delay must be < the period");
+
+  static constexpr Sch_Tick_t Interval = Period;
+  static constexpr Sch_Tick_t Offset = Delay;
+  static constexpr uint32_t Wcet = WcetUs;
+
+  static inline void Run(void)
+  {
+    Function();
+  }
+};
+
+namespace Detail
+{
+/**
+* The greatest common divisor.
+*/
+constexpr uint64_t Gcd(uint64_t A, uint64_t B)
+{
+  uint64_t Rest = 0;
+
+  for (; B != 0; A = B, B = Rest)
+    {
+      Rest = A % B;
+    }
+  return A;
+}
+
+/**
+* The LCM of the task periods, or 0 if it's over SCH_BALANCE_MAX_HYPER
+* ticks: the hyperperiod is then too long to be enumerated.
+*/
+template <typename... Tasks>
+constexpr uint64_t Lcm(void)
+{
+  const Sch_Tick_t Periods[] = { Tasks::Interval... };
+  uint64_t Result = 1;
+
+  for (size_t Index = 0; Index < sizeof...(Tasks); Index++)
+    {
+      Result = Result / Gcd(Result, Periods[Index]) * Periods[Index];
+      if (Result > SCH_BALANCE_MAX_HYPER)
+        {
+          return 0;
+        }
+    }
+  return Result;
+}
+
+/**
+* The highest sum of WCETs released in one tick: exact over the
+* hyperperiod when it's known, else bounded pairwise. The releases of
+* two tasks can coincide only if their delays are congruent modulo the
+* GCD of their periods, so no tick releases more than a task plus every
+* task that can coincide with it.
+*/
+template <typename... Tasks>
+constexpr uint64_t PeakLoad(const uint64_t Hyperperiod)
+{
+  const Sch_Tick_t Periods[] = { Tasks::Interval... };
+  const Sch_Tick_t Delays[] = { Tasks::Offset... };
+  const uint32_t Wcets[] = { Tasks::Wcet... };
+  uint64_t Peak = 0, Load = 0, Tick = 0, Divisor = 0;
+  size_t Index = 0, Other = 0;
+
+  if (((uint64_t)Tasks::Wcet + ...) == 0)
+    {
+      return 0;
+    }
+  for (Tick = 0; Tick < Hyperperiod; Tick++)
+    {
+      Load = 0;
+      for (Index = 0; Index < sizeof...(Tasks); Index++)
+        {
+          if (Tick % Periods[Index] == Delays[Index])
+            {
+              Load += Wcets[Index];
+            }
+        }
+      Peak = Load > Peak ? Load : Peak;
+    }
+  for (Index = 0; Hyperperiod == 0 && Index < sizeof...(Tasks); Index++)
+    {
+      Load = Wcets[Index];
+      for (Other = 0; Other < sizeof...(Tasks); Other++)
+        {
+          Divisor = Gcd(Periods[Index], Periods[Other]);
+          if (Other != Index && Delays[Index] % Divisor == Delays[Other] % Divisor)
+            {
+              Load += Wcets[Other];
+            }
+        }
+      Peak = Load > Peak ? Load : Peak;
+    }
+  return Peak;
+}
+} /* end namespace Detail */
+
+/**
+* A compile-time task table. Update marks the due tasks of one tick and
+* Dispatch runs them in table order, both with one unrolled step per task
+* and no function pointer. Attach adds Run to the C scheduler, which then
+* provides the timer, the sleep and the backends.
+*
+* \b Example:
+* @code
+* using Tasks = Sch::Table<Sch::Task<count1, 100, 0, 200>,
+*                          Sch::Task<count2, 50, 1, 150>>;
+* Sch_Init();
+* Tasks::Attach();
+* Sch_Start();
+* while (1)
+*   {
+*     Sch_Update();
+*   }
+* @endcode
+*/
+template <typename... Tasks>
+class Table
+{
+public:
+  static constexpr size_t Size = sizeof...(Tasks);
+
+  static_assert(Size > 0, "Sch::Table: the table is empty");
+
+  /*< The LCM of the periods, 0 if over SCH_BALANCE_MAX_HYPER ticks */
+  static constexpr uint64_t Hyperperiod = Detail::Lcm<Tasks...>();
+  /*< The highest run time released in a tick, in us: exact over the
+   *  hyperperiod, or a pairwise bound without it */
+  static constexpr uint64_t PeakLoad = Detail::PeakLoad<Tasks...>(Hyperperiod);
+
+  /*< The run time per hyperperiod must fit in it. Without a hyperperiod
+   *  the peak check below implies it: the mean tick load is at most the
+   *  peak */
+  static_assert(Hyperperiod == 0 ||
+                (((uint64_t)Tasks::Wcet * (Hyperperiod / Tasks::Interval)) + ...)
+                <= SCH_TICK_US * Hyperperiod,
+                "Sch::Table: the tick utilization is over 100%");
+  /*< And so must the run time released in any single tick */
+  static_assert(PeakLoad <= SCH_TICK_US,
+                "Sch::Table: a tick releases more than TICK of run time");
+
+  /**
+  * Marks the tasks due in this tick, as Sch_Tick does.
+  */
+  static inline void Update(void)
+  {
+    UpdateAll(std::index_sequence_for<Tasks...>{});
+  }
+
+  /**
+  * Runs each marked task once, as Sch_DispatchTasks does.
+  */
+  static inline void Dispatch(void)
+  {
+    DispatchAll(std::index_sequence_for<Tasks...>{});
+  }
+
+  /**
+  * One tick of the table, to be added as a task of period 1.
+  */
+  static void Run(void)
+  {
+    Update();
+    Dispatch();
+  }
+
+  /**
+  * Adds the table to the C scheduler.
+  *
+  * @return Sch_TaskId_t the id of the task driving the table, or
+  * SCH_NO_TASK if the C task table is full.
+  */
+  static Sch_TaskId_t Attach(void)
+  {
+    return Sch_AddTask(Run, 0, 1);
+  }
+
+  /**
+  * Restores the delays of every task and drops the pending runs.
+  */
+  static void Reset(void)
+  {
+    const Sch_Tick_t Delays[] = { Tasks::Offset... };
+
+    for (size_t Index = 0; Index < Size; Index++)
+      {
+        Countdown[Index] = Delays[Index];
+        RunMe[Index] = 0;
+      }
+  }
+
+private:
+  /*< Ticks until the next release of each task */
+  static inline Sch_Tick_t Countdown[Size] = { Tasks::Offset... };
+  /*< Pending runs of each task */
+  static inline Sch_Tick_t RunMe[Size] = {};
+
+  template <size_t Index, typename Entry>
+  static inline void UpdateOne(void)
+  {
+    if (Countdown[Index] == 0)
+      {
+        RunMe[Index]++;
+        Countdown[Index] = Entry::Interval - 1;
+      }
+    else
+      {
+        Countdown[Index]--;
+      }
+  }
+
+  template <size_t Index, typename Entry>
+  static inline void DispatchOne(void)
+  {
+    if (RunMe[Index] > 0)
+      {
+        Entry::Run();
+        RunMe[Index]--;
+      }
+  }
+
+  template <size_t... Indices>
+  static inline void UpdateAll(std::index_sequence<Indices...>)
+  {
+    (UpdateOne<Indices, Tasks>(), ...);
+  }
+
+  template <size_t... Indices>
+  static inline void DispatchAll(std::index_sequence<Indices...>)
+  {
+    (DispatchOne<Indices, Tasks>(), ...);
+  }
+};
+} /* end namespace Sch */
+
+#endif /* end SCH_HPP */
+/************************* END OF FILE ********************************/
@@ -19,7 +19,228 @@
 #define TICK 10
 
 /*< The maximum number of tasks in the project */
+#ifndef SCH_MAX_TASKS
 #define SCH_MAX_TASKS (2)
+#endif
+
+/*< The type of task ids, it must hold SCH_MAX_TASKS + 1 values. The bits
+ *  above the slot hold its generation, which tells stale ids apart */
+#ifndef SCH_TASK_ID_TYPE
+#define SCH_TASK_ID_TYPE uint16_t
+#endif
+
+/*< The type of tick counts (delays, periods and pending runs),
+ *  an unsigned type up to 32-bit */
+#ifndef SCH_TICK_TYPE
+#define SCH_TICK_TYPE uint32_t
+#endif
+
+/*< Available tick engines (see SCH_ENGINE) */
+#define SCH_ENGINE_LINEAR 0 /*< scan the whole task table every tick */
+#define SCH_ENGINE_WHEEL  1 /*< hierarchical timing wheel, a tick only touches due tasks */
+#define SCH_ENGINE_TABLE  2 /*< static schedule table generated offline (sch_table.h) */
+
+/*< The engine used by Sch_Update to find the tasks that are due.
+ *  SCH_ENGINE_LINEAR is the cheapest for a handful of tasks, 
+ *  SCH_ENGINE_WHEEL keeps the tick cost flat for thousands of tasks.
+ *  SCH_ENGINE_TABLE is a single table lookup per tick for a static task
+ *  set, generate sch_table.h with tools/sch_table_gen first. */
+#ifndef SCH_ENGINE
+#define SCH_ENGINE SCH_ENGINE_LINEAR
+#endif
+
+/*< Available task table layouts (see SCH_LAYOUT) */
+#define SCH_LAYOUT_AOS 0 /*< one TaskConfig_t per task */
+#define SCH_LAYOUT_SOA 1 /*< the delays in a dense vector array, with an occupancy bitmap */
+
+/*< The task table layout. SCH_LAYOUT_SOA makes the SCH_ENGINE_LINEAR
+ *  tick decrement every delay with vector instructions (SSE2, AVX2 or
+ *  NEON, whatever the compiler targets) and touch a task entry only when
+ *  it expires; it pays off from hundreds of tasks. LINEAR engine only */
+#ifndef SCH_LAYOUT
+#define SCH_LAYOUT SCH_LAYOUT_AOS
+#endif
+
+/*< Number of task priorities (see Sch_SetTaskPriority). A dispatch round
+ *  runs the due tasks of priority 0 first, then 1 and so on */
+#ifndef SCH_PRIORITIES
+#define SCH_PRIORITIES 1u
+#endif
+
+/*< The CPU time a dispatch round may take, in us (CLOCK_MONOTONIC), 0 for
+ *  no limit. The priority 0 tasks always run, the lower priority ones not
+ *  started when it is spent keep their runs for the next round */
+#ifndef SCH_DISPATCH_BUDGET_US
+#define SCH_DISPATCH_BUDGET_US 0u
+#endif
+
+/*< Tickless idle: 1 to sleep until the next due task with a one-shot
+ *  timer instead of waking up every TICK, 0 for the periodic tick */
+#ifndef SCH_TICKLESS
+#define SCH_TICKLESS 0
+#endif
+
+/*< 1: ticks are absolute times, tick k is due at the CLOCK_MONOTONIC
+ *  time of tick 0 + k * TICK. The timer is re-armed with TIMER_ABSTIME
+ *  for the next tick and the ticks to process are read from the clock,
+ *  so a lost or late timer wakeup never shifts the task phases.
+ *  SCH_TICKLESS implies it */
+#ifndef SCH_ABSTIME
+#define SCH_ABSTIME 0
+#endif
+
+/*< The longest tickless sleep in ticks, even when no task is due */
+#ifndef SCH_TICKLESS_MAX_IDLE
+#define SCH_TICKLESS_MAX_IDLE 1000u
+#endif
+
+/*< The number of scheduler instances, one per worker thread started
+ *  by Sch_StartCores. Instance 0 also serves the Sch_* functions. */
+#ifndef SCH_MAX_CORES
+#define SCH_MAX_CORES 1
+#endif
+
+/*< The CPU the worker thread of a core is pinned to */
+#ifndef SCH_CORE_CPU
+#define SCH_CORE_CPU(Core) (Core)
+#endif
+
+/*< Available dispatch modes (see SCH_DISPATCH) */
+#define SCH_DISPATCH_SERIAL   0 /*< each core runs one instance of its due tasks per round */
+#define SCH_DISPATCH_STEALING 1 /*< due instances go to per-core deques, idle cores steal */
+
+/*< How the due tasks are run. With SCH_DISPATCH_STEALING a RunMe backlog
+ *  drains in parallel over the cores, except for the tasks pinned with
+ *  Sch_SetTaskAffinity. */
+#ifndef SCH_DISPATCH
+#define SCH_DISPATCH SCH_DISPATCH_SERIAL
+#endif
+
+/*< The capacity of each work-stealing deque, a power of 2 */
+#ifndef SCH_DEQUE_SIZE
+#define SCH_DEQUE_SIZE 256
+#endif
+
+/*< The capacity of the command queue of Sch_PostAddTask/Sch_PostDeleteTask,
+ *  a power of 2: the changes other threads can post between two ticks */
+#ifndef SCH_CMD_QUEUE_SIZE
+#define SCH_CMD_QUEUE_SIZE 64u
+#endif
+
+/*< Available timer backends (see SCH_BACKEND) */
+#define SCH_BACKEND_SIGNAL  0 /*< POSIX timer + TIMER_SIG, sleeps in pause() */
+#define SCH_BACKEND_TIMERFD 1 /*< timerfd + epoll, no signal at all */
+#define SCH_BACKEND_SIM     2 /*< simulated clock, no timer and no sleep (Sch_SimRun) */
+
+/*< How the scheduler sleeps between ticks. SCH_BACKEND_TIMERFD counts
+ *  missed ticks exactly and can also wait on application descriptors
+ *  (Sch_AddFd), without the application masking TIMER_SIG.
+ *  SCH_BACKEND_SIM runs a whole schedule as fast as the CPU allows: every
+ *  sleep jumps a virtual clock to the wakeup and every task run advances
+ *  it by the task WCET (Sch_SetTaskWcet), or by its measured run time.
+ *  One instance only */
+#ifndef SCH_BACKEND
+#define SCH_BACKEND SCH_BACKEND_SIGNAL
+#endif
+
+/*< The number of application descriptors Sch_AddFd can watch */
+#ifndef SCH_MAX_FDS
+#define SCH_MAX_FDS 8
+#endif
+
+/*< 1: time every task run (min/max/mean, histogram, overruns) and the
+ *  tick-to-dispatch latency, read them with Sch_GetTaskStats/Sch_GetStats.
+ *  0: no field and no clock read is compiled in. SCH_BACKEND_SIM needs it
+ *  for Sch_SimReport */
+#ifndef SCH_STATS
+#define SCH_STATS (SCH_BACKEND == SCH_BACKEND_SIM)
+#endif
+
+/*< Run time histogram buckets: bucket 0 counts runs under 1us, bucket i
+ *  runs in [2^(i-1), 2^i) us, the last one every longer run */
+#ifndef SCH_STATS_BUCKETS
+#define SCH_STATS_BUCKETS 16
+#endif
+
+/*< 1: publish the per-task and per-instance counters to a POSIX shared
+ *  memory segment opened by Sch_ShmOpen (layout in sch_shm.h), for
+ *  tools/sch_top. The tick path only stores to the mapped memory, the
+ *  run times need SCH_STATS too. 0: nothing is compiled in */
+#ifndef SCH_SHM
+#define SCH_SHM 0
+#endif
+
+/*< 1: record the ticks, releases, task runs, overruns and sleeps of
+ *  every instance in its own ring buffer (CLOCK_MONOTONIC_RAW stamps),
+ *  written to a file by Sch_TraceDump (layout in sch_trace.h) and
+ *  converted for chrome://tracing or Perfetto by tools/sch_trace2json.
+ *  0: nothing is compiled in */
+#ifndef SCH_TRACE
+#define SCH_TRACE 0
+#endif
+
+/*< The events kept per instance, a power of 2: the oldest ones are
+ *  overwritten. 16 bytes each */
+#ifndef SCH_TRACE_SIZE
+#define SCH_TRACE_SIZE 4096u
+#endif
+
+/*< A signal that makes the Sch_Start thread dump the trace to
+ *  SCH_TRACE_PATH at its next wakeup, e.g. SIGUSR2. 0 for none */
+#ifndef SCH_TRACE_SIGNAL
+#define SCH_TRACE_SIGNAL 0
+#endif
+
+/*< The file of a signal triggered dump, %d is replaced by the pid */
+#ifndef SCH_TRACE_PATH
+#define SCH_TRACE_PATH "sch_trace.%d.bin"
+#endif
+
+/*< 1: Sch_Start and the worker threads go real-time before starting the
+ *  timer: SCHED_FIFO, CPU affinity, mlockall and stack prefault, each
+ *  step reported on stderr and by Sch_GetRtReport */
+#ifndef SCH_RT
+#define SCH_RT 0
+#endif
+
+/*< The SCHED_FIFO priority of the scheduler threads (1..99) */
+#ifndef SCH_RT_PRIORITY
+#define SCH_RT_PRIORITY 80
+#endif
+
+/*< The CPU Sch_Start pins the calling thread to, -1 to leave it as is.
+ *  Worker threads use SCH_CORE_CPU */
+#ifndef SCH_RT_CPU
+#define SCH_RT_CPU (-1)
+#endif
+
+/*< The stack bytes touched once so the tick path never page faults */
+#ifndef SCH_RT_PREFAULT_STACK
+#define SCH_RT_PREFAULT_STACK (64u * 1024u)
+#endif
+
+/*< The coarsest CLOCK_MONOTONIC resolution accepted, in ns */
+#ifndef SCH_RT_MAX_CLOCK_RES
+#define SCH_RT_MAX_CLOCK_RES 1000u
+#endif
+
+/*< The longest load profile Sch_AddTaskAuto and Sch_Rebalance build, in
+ *  ticks. Up to it the offsets are chosen over the exact hyperperiod,
+ *  above it over this horizon only */
+#ifndef SCH_BALANCE_MAX_HYPER
+#define SCH_BALANCE_MAX_HYPER 10000u
+#endif
+
+/*< The most due instances of one batch task passed in a single call */
+#ifndef SCH_BATCH_MAX
+#define SCH_BATCH_MAX 64u
+#endif
+
+/*< The batch task functions grouped per dispatch round, the instances
+ *  of any further function are called one at a time */
+#ifndef SCH_BATCH_GROUPS
+#define SCH_BATCH_GROUPS 4u
+#endif
 
 #endif /* end CFG_H */
 /************************* END OF FILE ********************************/
@@ -0,0 +1,161 @@
+/**
+ * @file sch_shm.h
+ * @author Mohamed Hassanin
+ * @brief Layout of the statistics segment published by the scheduler
+ * (SCH_SHM, see Sch_ShmOpen) and read by tools/sch_top.
+ *
+ *  The segment is a POSIX shared memory object:
+ *    Sch_ShmHeader_t
+ *    Sch_ShmCore_t  [Cores]            at sizeof(Sch_ShmHeader_t)
+ *    Sch_ShmTask_t  [Cores][MaxTasks]  right after the cores
+ *  Readers use CoreSize and TaskSize from the header, so a later version
+ *  may append fields to the entries without breaking them.
+ *
+ *  Every core and task entry is written by a single thread, the one
+ *  running its instance, under a sequence lock: Seq is odd while the
+ *  entry is being written. A reader copies the entry and retries when
+ *  Seq was odd or changed meanwhile; the writer never waits.
+ * @version 0.1
+ * @date 2021-02-14
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#ifndef SCH_SHM_H
+#define SCH_SHM_H
+/**********************************************************************
+* Includes
+**********************************************************************/
+#include <inttypes.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/**********************************************************************
+* Module Preprocessor Constants
+**********************************************************************/
+#define SCH_SHM_MAGIC 0x4D485343u /*< "CSHM", written last by Sch_ShmOpen */
+#define SCH_SHM_VERSION 2u
+
+/*< Header flags */
+#define SCH_SHM_TIMED 0x1u /*< Built with SCH_STATS: the run times are filled in */
+/**********************************************************************
+* Typedefs
+**********************************************************************/
+/**
+* The start of the segment, written once by Sch_ShmOpen.
+*/
+typedef struct
+{
+  uint32_t Magic; /*< SCH_SHM_MAGIC once the segment is ready */
+  uint32_t Version; /*< SCH_SHM_VERSION */
+  uint32_t Flags; /*< SCH_SHM_TIMED */
+  uint32_t Cores; /*< Core entries, SCH_MAX_CORES */
+  uint32_t MaxTasks; /*< Task entries per core, SCH_MAX_TASKS */
+  uint32_t CoreSize; /*< sizeof(Sch_ShmCore_t) of the writer */
+  uint32_t TaskSize; /*< sizeof(Sch_ShmTask_t) of the writer */
+  uint32_t TickUs; /*< The tick length */
+  int64_t Pid; /*< The scheduler process */
+  uint64_t Size; /*< The whole segment in bytes */
+} Sch_ShmHeader_t;
+
+/**
+* The counters of one scheduler instance, published once per dispatch
+* round.
+*/
+typedef struct
+{
+  uint32_t Seq; /*< Sequence lock, odd while written */
+  uint32_t Reserved;
+  uint64_t Ticks; /*< Ticks processed */
+  uint64_t Wakeups; /*< Times the instance woke up from sleep */
+  uint64_t Rounds; /*< Dispatch rounds */
+  uint64_t Dispatches; /*< Task runs started (SCH_SHM_TIMED) */
+  uint64_t Backlog; /*< Sum of the runs left pending behind a dispatched one (SCH_SHM_TIMED) */
+  uint64_t MaxBacklog; /*< The largest RunMe seen at dispatch time (SCH_SHM_TIMED) */
+  uint64_t BudgetCuts; /*< Rounds stopped by SCH_DISPATCH_BUDGET_US (SCH_SHM_TIMED) */
+  uint64_t LatencyMaxNs; /*< Longest tick-to-dispatch latency (SCH_SHM_TIMED) */
+  uint64_t LatencyTotalNs; /*< Sum of the latencies (SCH_SHM_TIMED) */
+  uint64_t LatencySamples; /*< Runs whose latency was measured (SCH_SHM_TIMED) */
+} Sch_ShmCore_t;
+
+/**
+* The counters of one task slot, published when the task is added,
+* deleted or visited by a dispatch round.
+*/
+typedef struct
+{
+  uint32_t Seq; /*< Sequence lock, odd while written */
+  uint32_t Live; /*< 1 while a task holds the slot */
+  uint32_t Period; /*< Ticks between two releases, 0 for one-shot and event tasks */
+  uint32_t RunMe; /*< Pending runs */
+  uint64_t Releases; /*< Runs released, by the clock or Sch_PostEvent */
+  uint64_t Dispatches; /*< Runs started */
+  uint64_t Missed; /*< Releases that came while a run was still pending */
+  uint64_t Overruns; /*< Runs longer than a tick (SCH_SHM_TIMED) */
+  uint64_t MinNs; /*< Shortest run (SCH_SHM_TIMED) */
+  uint64_t MaxNs; /*< Longest run (SCH_SHM_TIMED) */
+  uint64_t TotalNs; /*< Sum of the runs (SCH_SHM_TIMED) */
+} Sch_ShmTask_t;
+/**********************************************************************
+* Function Definitions
+**********************************************************************/
+/**
+ * @brief Start writing the entry guarded by Seq (single writer).
+ */
+static inline void Shm_WriteBegin(uint32_t *Seq)
+{
+  __atomic_store_n(Seq, __atomic_load_n(Seq, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+  // The odd Seq is visible before any field changes
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Publish the entry guarded by Seq.
+ */
+static inline void Shm_WriteEnd(uint32_t *Seq)
+{
+  __atomic_store_n(Seq, __atomic_load_n(Seq, __ATOMIC_RELAXED) + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Copy a consistent snapshot of an entry starting with its Seq.
+ *
+ * @param Dst where the entry is copied to.
+ * @param Src the entry in the segment.
+ * @param Size the entry size.
+ * @param Tries the attempts before giving up.
+ *
+ * @return int 0, or -1 if every attempt raced with the writer.
+ */
+static inline int Shm_Read(void *Dst, const void *Src, const size_t Size, uint32_t Tries)
+{
+  const uint32_t *Seq = (const uint32_t *)Src;
+  uint32_t Before, After;
+
+  while (Tries-- > 0)
+    {
+      Before = __atomic_load_n(Seq, __ATOMIC_ACQUIRE);
+      if (Before & 1u)
+        {
+          continue;
+        }
+      memcpy(Dst, Src, Size);
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      After = __atomic_load_n(Seq, __ATOMIC_RELAXED);
+      if (Before == After)
+        {
+          return 0;
+        }
+    }
+  return -1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end SCH_SHM_H */
+/************************* END OF FILE ********************************/
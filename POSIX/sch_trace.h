@@ -0,0 +1,93 @@
+/**
+ * @file sch_trace.h
+ * @author Mohamed Hassanin
+ * @brief Event records of the scheduler trace (SCH_TRACE) and layout of
+ * the file written by Sch_TraceDump, read by tools/sch_trace2json.
+ *
+ *  The file is:
+ *    Sch_TraceHeader_t
+ *    then, for each of the Cores instances:
+ *      Sch_TraceBlock_t
+ *      Sch_TraceEvent_t [Count], oldest first
+ *  Every integer is in the byte order of the machine that wrote it.
+ * @version 0.1
+ * @date 2021-02-14
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#ifndef SCH_TRACE_H
+#define SCH_TRACE_H
+/**********************************************************************
+* Includes
+**********************************************************************/
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/**********************************************************************
+* Module Preprocessor Constants
+**********************************************************************/
+#define SCH_TRACE_MAGIC 0x52544353u /*< "SCTR" */
+#define SCH_TRACE_VERSION 1u
+/**********************************************************************
+* Typedefs
+**********************************************************************/
+/**
+* The event types, what Id and Arg of a record hold.
+*/
+typedef enum
+{
+  SCH_TRACE_TICK = 1, /*< Ticks processed: Id the next tick, Arg how many (saturated) */
+  SCH_TRACE_RELEASE, /*< Task released: Id the task, Arg the runs released */
+  SCH_TRACE_RUN_START, /*< Task run started: Id the task, Arg the instances (batch) */
+  SCH_TRACE_RUN_END, /*< Task run ended: Id the task, Arg the instances (batch) */
+  SCH_TRACE_OVERRUN, /*< The run that just ended took longer than a tick: Id the task */
+  SCH_TRACE_SLEEP_ENTER, /*< The instance thread goes to sleep */
+  SCH_TRACE_SLEEP_EXIT /*< The instance thread woke up */
+} Sch_TraceType_t;
+
+/**
+* One trace record, 16 bytes.
+*/
+typedef struct
+{
+  uint64_t Ns; /*< CLOCK_MONOTONIC_RAW time */
+  uint32_t Id; /*< Task id or tick, see Sch_TraceType_t */
+  uint16_t Arg; /*< See Sch_TraceType_t */
+  uint8_t Type; /*< Sch_TraceType_t */
+  uint8_t Owner; /*< The instance the task belongs to, another one for a stolen run */
+} Sch_TraceEvent_t;
+
+/**
+* The start of a dump file.
+*/
+typedef struct
+{
+  uint32_t Magic; /*< SCH_TRACE_MAGIC */
+  uint32_t Version; /*< SCH_TRACE_VERSION */
+  uint32_t Cores; /*< The blocks that follow, SCH_MAX_CORES */
+  uint32_t TickUs; /*< The tick length */
+  int64_t Pid; /*< The traced process */
+  uint32_t EventSize; /*< sizeof(Sch_TraceEvent_t) */
+  uint32_t Reserved;
+} Sch_TraceHeader_t;
+
+/**
+* The events of one instance in a dump file.
+*/
+typedef struct
+{
+  uint32_t Core; /*< The instance index */
+  uint32_t Count; /*< The events that follow */
+  uint64_t Lost; /*< The older events overwritten before the dump */
+} Sch_TraceBlock_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end SCH_TRACE_H */
+/************************* END OF FILE ********************************/
@@ -0,0 +1,77 @@
+/**
+ * @file batch_delete.c
+ * @author Mohamed Hassanin
+ * @brief Regression check: a batch instance deleted by a task of the
+ *  same round must not be called by its group, neither with the cleared
+ *  entry nor with the task re-added in its slot. Built by make check,
+ *  with and without SCH_DISPATCH_BUDGET_US, it exits with 1 on failure.
+ * @version 0.1
+ * @date 2021-03-06
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "sch.h"
+
+static int First = 1, Second = 2;
+static Sch_TaskId_t Victim;
+static uint32_t Round, Calls;
+
+static void Filter(void **Ctx, uint32_t Count)
+{
+  uint32_t Index;
+
+  // The deleted instance, or the one re-added in its slot, not due yet
+  for (Index = 0; Index < Count; Index++)
+    {
+      printf("round %u: called with %p\n", (unsigned)Round, Ctx[Index]);
+    }
+  Calls += Count;
+}
+
+static void Deleter(void)
+{
+  struct timespec Start, Now;
+
+  if (Round == 0)
+    {
+      // Spends more than SCH_DISPATCH_BUDGET_US, if set, before the group
+      // runs: its instances get their runs back instead
+      clock_gettime(CLOCK_MONOTONIC, &Start);
+      do
+        {
+          clock_gettime(CLOCK_MONOTONIC, &Now);
+        }
+      while ((Now.tv_sec - Start.tv_sec) * 1000000000L +
+             (Now.tv_nsec - Start.tv_nsec) < 300000);
+      Sch_DeleteTask(Victim);
+      Sch_AddTaskBatch(Filter, &Second, 5, 10);
+    }
+  Round++;
+}
+
+int main(void)
+{
+  uint32_t Index;
+
+  Sch_Init();
+  Victim = Sch_AddTaskBatch(Filter, &First, 0, 1);
+  Sch_AddTask(Deleter, 0, 1);
+  Sch_Start();
+  for (Index = 0; Index < 3; Index++)
+    {
+      Sch_Update();
+    }
+  Sch_Deinit();
+
+  if (Calls != 0)
+    {
+      printf("FAIL: %u batch calls after the delete\n", (unsigned)Calls);
+      return EXIT_FAILURE;
+    }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -14,7 +14,7 @@ main(void)
 {
   Sch_Init();
 
-  uint8_t task1Id = Sch_AddTask(Task1, 0, 100);
+  Sch_TaskId_t task1Id = Sch_AddTask(Task1, 0, 100);
   
   Sch_Start();
   
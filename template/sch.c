@@ -16,6 +16,9 @@
 #include <inttypes.h>
 #include "sch.h"
 #include "sch_cfg.h"
+#if SCH_STATIC_TABLE
+#include "sch_table.h"
+#endif
 /**********************************************************************
 * Typedefs
 **********************************************************************/
@@ -26,18 +29,35 @@
 typedef struct 
 {
   void (*Task)(void); /*< a pointer to the task function */
-  uint16_t Delay; /*< Delay in ticks until the function runs */
-  uint32_t Period; /*< Interval (ticks) between subsequent runs. */
-  uint16_t RunMe; /*< Incremented (by scheduler) when task is due to execute */
+  Sch_Tick_t Delay; /*< Delay in ticks until the function runs */
+  Sch_Tick_t Period; /*< Interval (ticks) between subsequent runs. */
+  Sch_Tick_t RunMe; /*< Incremented (by scheduler) when task is due to execute */
+  uint8_t Event; /*< Released by Sch_PostEvent only, never by the timer */
 } TaskConfig_t;
+
+#if SCH_STATIC_TABLE
+_Static_assert(SCH_TABLE_TASKS <= SCH_MAX_TASKS, "the schedule table has more tasks than SCH_MAX_TASKS");
+#endif
+/* SCH_NO_TASK must never be a valid task id */
+_Static_assert(SCH_MAX_TASKS < SCH_NO_TASK, "Sch_TaskId_t is too narrow for SCH_MAX_TASKS");
 /**********************************************************************
 * Module Variable Definitions
 **********************************************************************/
 static TaskConfig_t Config[SCH_MAX_TASKS];
+/* Byte stores, so posting needs no critical section on any CPU */
+static volatile uint8_t Posted[SCH_MAX_TASKS]; /*< Set by Sch_PostEvent */
+static volatile uint8_t AnyPosted; /*< Set after any Posted entry */
+static volatile uint8_t TickPending; /*< Set by the timer interrupt */
+#if SCH_STATIC_TABLE
+static uint32_t TableIndex; /*< The schedule table entry of the next tick */
+#endif
 /**********************************************************************
 * Function Prototypes
 **********************************************************************/
 static void Sch_GoToSleep(void);
+static void Sch_Tick(void);
+static Sch_TaskId_t Sch_AddEntry(void (*Function)(void), const Sch_Tick_t Delay,
+                                 const Sch_Tick_t Period, const uint8_t Event);
 /**********************************************************************
 * Function Definitions
 **********************************************************************/
@@ -63,10 +83,12 @@ void
 Sch_Init(void)
 {
   //set the task parameters.
-  for (uint8_t TaskIndex = 0; TaskIndex < SCH_MAX_TASKS; TaskIndex++)
+  for (Sch_TaskId_t TaskIndex = 0; TaskIndex < SCH_MAX_TASKS; TaskIndex++)
     {
       Sch_DeleteTask(TaskIndex);
     }
+  AnyPosted = 0;
+  TickPending = 0;
 
   //TODO: configure and init the timer used for the scheduler and its interrupt.
 }
@@ -91,7 +113,7 @@ Sch_Init(void)
 **********************************************************************/
 void Sch_DispatchTasks(void)
 {
-  uint8_t TaskId;
+  Sch_TaskId_t TaskId;
   
   // Dispatches (runs) the next task (if one is ready)
   for (TaskId = 0; TaskId < SCH_MAX_TASKS; TaskId++)
@@ -100,6 +122,11 @@ void Sch_DispatchTasks(void)
         {
           (*Config[TaskId].Task)(); // Run the task
           Config[TaskId].RunMe -= 1; // Reset / reduce RunMe flag
+          // A one-shot task runs once, then frees its slot
+          if (Config[TaskId].Period == 0 && !Config[TaskId].Event)
+            {
+              Sch_DeleteTask(TaskId);
+            }
         }
     }
 }
@@ -127,7 +154,13 @@ void Sch_DispatchTasks(void)
 static void 
 Sch_GoToSleep(void)
 {
-  //TODO: Identifiy the sleep instruction
+  //TODO: disable the interrupts
+  // A tick or a post that came during the dispatch is handled right away
+  if (!TickPending && !AnyPosted)
+    {
+      //TODO: Identifiy the sleep instruction, entered as the interrupts are enabled again
+    }
+  //TODO: enable the interrupts
 }
 
 /*********************************************************************
@@ -135,44 +168,183 @@ Sch_GoToSleep(void)
 *//**
 * \b Description:
 *
-* This function is used to add task to the scheduler. 
+* This function is used to add task to the scheduler. A one-shot task
+* (Period 0) runs once, Delay ticks from now, then its slot is freed and
+* its id may be handed out again. SCH_STATIC_TABLE has no one-shot tasks.
 *
 * PRE-CONDITION: Sch_Init() is called <br>
 * POST-CONDITION: The task will be added to the scheduler.
 *
 * @param Function a function pointer to the task function.
 * @param Delay a delay before the function executed for its first time
-* @param Period the period of the task
+* @param Period the period of the task, 0 for a one-shot task
 *
-* @return uint8_t the id of the task
+* @return Sch_TaskId_t the id of the task, or SCH_NO_TASK if the task
+* table is full.
 *
 * \b Example:
 * @code
 * Sch_Init();
 * Sch_AddTask(count, 0, 10); // Make a task starting at 0 tick with period 10 ticks. 
+* Sch_AddTask(retry, 50, 0); // Run retry once, 50 ticks from now.
 * @endcode
 *
 * @see Sch_Init
 *
 **********************************************************************/
-uint8_t 
+Sch_TaskId_t 
 Sch_AddTask(void (*Function)(),
-      const uint32_t Delay,
-      const uint32_t Period)
+      const Sch_Tick_t Delay,
+      const Sch_Tick_t Period)
+{
+  return Sch_AddEntry(Function, Delay, Period, 0);
+}
+
+/*********************************************************************
+* Function : Sch_AddEventTask()
+*//**
+* \b Description:
+*
+* This function is used to add a task that the timer never releases:
+* it runs in the Sch_Update that follows a Sch_PostEvent for it, instead
+* of polling its input from a periodic task. The task stays until it's
+* deleted.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The task will be added to the scheduler.
+*
+* @param Function a function pointer to the task function.
+*
+* @return Sch_TaskId_t the id of the task, or SCH_NO_TASK if the task
+* table is full (or, with SCH_STATIC_TABLE, the next free id is a table
+* one: add the event tasks after the table tasks).
+*
+* \b Example:
+* @code
+* Sch_Init();
+* RxTask = Sch_AddEventTask(handleRx);
+* @endcode
+*
+* @see Sch_PostEvent
+*
+**********************************************************************/
+Sch_TaskId_t 
+Sch_AddEventTask(void (*Function)(void))
+{
+  return Sch_AddEntry(Function, 0, 0, 1);
+}
+
+/*********************************************************************
+* Function : Sch_PostEvent()
+*//**
+* \b Description:
+*
+* This function is used to release a task once, from an interrupt
+* handler or from a task. It only stores bytes, so it needs neither a
+* lock nor a critical section. The task runs in the next Sch_Update,
+* which the interrupt wakes the CPU up for; the posts that come before
+* it are merged into one release. Any task can be posted, event tasks
+* are only released this way.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The task is released by the next Sch_Update.
+*
+* @param TaskId the id returned by Sch_AddEventTask or Sch_AddTask.
+*
+* @return int 0, or -1 for an invalid id.
+*
+* \b Example:
+* @code
+* void UartRxHandler(void)
+* {
+*   Sch_PostEvent(RxTask);
+* }
+* @endcode
+*
+* @see Sch_AddEventTask
+*
+**********************************************************************/
+int 
+Sch_PostEvent(const Sch_TaskId_t TaskId)
+{
+  if (TaskId >= SCH_MAX_TASKS)
+    {
+      return -1;
+    }
+  Posted[TaskId] = 1;
+  // Set last: Sch_Update clears it before it looks at Posted
+  AnyPosted = 1;
+  return 0;
+}
+
+/*********************************************************************
+* Function : Sch_AddEntry()
+*//**
+* \b Description:
+* Utility function used to add a task in the first free slot.
+*
+* @param Function a function pointer to the task function.
+* @param Delay a delay before the function executed for its first time
+* @param Period the period of the task, 0 for a one-shot task
+* @param Event 1 for a task released by Sch_PostEvent only, Delay and
+* Period are then ignored.
+*
+* @return Sch_TaskId_t the id of the task, or SCH_NO_TASK.
+*
+* @see Sch_AddTask
+**********************************************************************/
+static Sch_TaskId_t 
+Sch_AddEntry(void (*Function)(void),
+      const Sch_Tick_t Delay,
+      const Sch_Tick_t Period,
+      const uint8_t Event)
 {
-  uint8_t TaskId = 0;
+  Sch_TaskId_t TaskId = 0;
 
   // First find a gap in the array (if there is one)
-  while ((Config[TaskId].Task != 0x0) && (TaskId < SCH_MAX_TASKS))
+  while ((TaskId < SCH_MAX_TASKS) && (Config[TaskId].Task != 0x0))
     {
       TaskId++;
     }
 
+  if (TaskId == SCH_MAX_TASKS)
+    {
+      // The task table is full
+      return SCH_NO_TASK;
+    }
+#if SCH_STATIC_TABLE
+  Sch_Tick_t TableDelay, TablePeriod;
+
+  // The event tasks go after the table ones, the table never lists them
+  if (Event)
+    {
+      if (TaskId < SCH_TABLE_TASKS)
+        {
+          return SCH_NO_TASK;
+        }
+    }
+  // The schedule table was generated for this id, delay and period
+  else if (TaskId >= SCH_TABLE_TASKS)
+    {
+      return SCH_NO_TASK;
+    }
+  else
+    {
+      SCH_TABLE_READ(TableDelay, SchTableDelay[TaskId]);
+      SCH_TABLE_READ(TablePeriod, SchTablePeriod[TaskId]);
+      if (Delay != TableDelay || Period != TablePeriod)
+        {
+          return SCH_NO_TASK;
+        }
+    }
+#endif
+
   // If we're here, there is a space in the task array
   Config[TaskId].Task = Function;
-  Config[TaskId].Delay = Delay;
-  Config[TaskId].Period = Period;
+  Config[TaskId].Delay = Event ? 0 : Delay;
+  Config[TaskId].Period = Event ? 0 : Period;
   Config[TaskId].RunMe = 0;
+  Config[TaskId].Event = Event;
 
   return TaskId;
 }
@@ -187,14 +359,14 @@ Sch_AddTask(void (*Function)(),
 * PRE-CONDITION: Sch_Init() is called <br>
 * POST-CONDITION: The task will be deleted.
 *
-* @param TaskId The id of the task to be deleted.
+* @param TaskId The id of the task to be deleted, SCH_NO_TASK is ignored.
 *
 * @return void
 *
 * \b Example:
 * @code
 * Sch_Init();
-* uint8_t taskId = Sch_AddTask(count, 0, 10); 
+* Sch_TaskId_t taskId = Sch_AddTask(count, 0, 10); 
 * Sch_DeleteTask(taskId);
 * @endcode
 *
@@ -203,12 +375,19 @@ Sch_AddTask(void (*Function)(),
 *
 **********************************************************************/
 void 
-Sch_DeleteTask(const uint8_t TaskId)
+Sch_DeleteTask(const Sch_TaskId_t TaskId)
 {
+  if (TaskId >= SCH_MAX_TASKS)
+    {
+      return;
+    }
   Config[TaskId].Task = 0x0;
   Config[TaskId].Delay = 0;
   Config[TaskId].Period = 0;
   Config[TaskId].RunMe = 0;
+  Config[TaskId].Event = 0;
+  // A post for the deleted task must not release the next one in the slot
+  Posted[TaskId] = 0;
 }
 
 /*********************************************************************
@@ -216,7 +395,8 @@ Sch_DeleteTask(const uint8_t TaskId)
 *//**
 * \b Description:
 *
-* this function used to schedule the tasks at every tick. 
+* this function used to schedule the tasks at every tick, and to release
+* the posted tasks when an interrupt wakes the CPU up between two ticks.
 *
 * PRE-CONDITION: Sch_Init() is called <br>
 * POST-CONDITION: The tasks are scheduled according to their configuration.
@@ -234,18 +414,105 @@ Sch_DeleteTask(const uint8_t TaskId)
 void 
 Sch_Update(void)
 {
-  uint8_t Index;
+  Sch_TaskId_t Index;
+
+  // An interrupt other than the timer one may have woken the CPU up
+  if (TickPending)
+    {
+      TickPending = 0;
+      Sch_Tick();
+    }
+
+  // A post that comes after its entry is checked is taken next time
+  if (AnyPosted)
+    {
+      AnyPosted = 0;
+      for (Index = 0; Index < SCH_MAX_TASKS; Index++)
+        {
+          if (Posted[Index])
+            {
+              Posted[Index] = 0;
+              if (Config[Index].Task != 0x0)
+                {
+                  Config[Index].RunMe += 1;
+                }
+            }
+        }
+    }
+
+  Sch_DispatchTasks();
+
+  // The scheduler enters idle mode at this point
+  Sch_GoToSleep();
+}
+
+/*********************************************************************
+* Function : Sch_Tick()
+*//**
+* \b Description:
+* Utility function used to release the tasks due at one timer tick.
+*
+* PRE-CONDITION: Sch_Init() is called <br>
+* POST-CONDITION: The due tasks have their RunMe incremented.
+*
+* @return void
+*
+* @see Sch_Update
+**********************************************************************/
+static void 
+Sch_Tick(void)
+{
+#if SCH_STATIC_TABLE
+  Sch_TaskId_t TaskId;
+#ifdef SCH_TABLE_LIST
+  uint32_t Entry, End;
+
+  // The tasks due this tick were listed offline
+  SCH_TABLE_READ(Entry, SchTableStart[TableIndex]);
+  SCH_TABLE_READ(End, SchTableStart[TableIndex + 1]);
+  for (; Entry < End; Entry++)
+    {
+      SCH_TABLE_READ(TaskId, SchTableIds[Entry]);
+#else
+  SCH_TABLE_MASK_TYPE Mask;
+
+  // The tasks due this tick were computed offline
+  SCH_TABLE_READ(Mask, SchTable[TableIndex]);
+  for (TaskId = 0; Mask != 0; TaskId++, Mask >>= 1)
+    {
+      if (!(Mask & 1))
+        {
+          continue;
+        }
+#endif
+      // A deleted task keeps its bits in the table
+      if (Config[TaskId].Task != 0x0)
+        {
+          Config[TaskId].RunMe += 1;
+        }
+    }
+  if (++TableIndex == SCH_TABLE_LENGTH)
+    {
+      TableIndex = 0;
+    }
+#else
+  Sch_TaskId_t Index;
+
   for (Index = 0; Index < SCH_MAX_TASKS; Index++)
     {
-      // Check if there is a task at this location
-      if (Config[Index].Task != 0x0)
+      // Check if there is a task released by the timer at this location
+      if (Config[Index].Task != 0x0 && !Config[Index].Event)
         {
           if (Config[Index].Delay == 0)
             {
               // The task is due to run
               Config[Index].RunMe += 1; 
-              // Schedule periodic tasks to run again
-              Config[Index].Delay = Config[Index].Period - 1;
+              // Schedule periodic tasks to run again, a one-shot task is
+              // deleted once it has run
+              if (Config[Index].Period != 0)
+                {
+                  Config[Index].Delay = Config[Index].Period - 1;
+                }
             }
           else
             {
@@ -254,11 +521,7 @@ Sch_Update(void)
             }
         }
     }
-  
-  Sch_DispatchTasks();
-
-  // The scheduler enters idle mode at this point
-  Sch_GoToSleep();
+#endif
 }
 
 /*********************************************************************
@@ -286,6 +549,8 @@ Sch_Update(void)
 void 
 Sch_Start(void)
 { 
+  //The first Sch_Update processes tick 0 right away
+  TickPending = 1;
   //TODO: Start the timer */
 }
 
@@ -306,7 +571,8 @@ Sch_Start(void)
 static void
 TimerHandler(void)
 {
-  //Do nothing, just wake up the CPU
+  //Wake up the CPU for a tick
+  TickPending = 1;
 	//TODO: clear the timer interrupt flag
 }
 
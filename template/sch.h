@@ -12,16 +12,33 @@
 * Includes
 **********************************************************************/
 #include <inttypes.h>
+#include "sch_cfg.h"
 /**********************************************************************
 * Module Preprocessor Constants
 **********************************************************************/
+/* Returned by Sch_AddTask when the task can't be added */
+#define SCH_NO_TASK ((Sch_TaskId_t)~(Sch_TaskId_t)0)
+/**********************************************************************
+* Typedefs
+**********************************************************************/
+/**
+* A task handle, returned by Sch_AddTask
+*/
+typedef SCH_TASK_ID_TYPE Sch_TaskId_t;
+
+/**
+* A count of ticks: task delays, periods and pending runs
+*/
+typedef SCH_TICK_TYPE Sch_Tick_t;
 /**********************************************************************
 * Function Prototypes
 **********************************************************************/
 void Sch_Init(void);
 void Sch_Deinit(void);
-uint8_t Sch_AddTask(void (*Task) (void), const uint32_t Delay, const uint32_t Interval);
-void Sch_DeleteTask(const uint8_t TaskId);
+Sch_TaskId_t Sch_AddTask(void (*Task) (void), const Sch_Tick_t Delay, const Sch_Tick_t Interval);
+Sch_TaskId_t Sch_AddEventTask(void (*Task) (void));
+int Sch_PostEvent(const Sch_TaskId_t TaskId);
+void Sch_DeleteTask(const Sch_TaskId_t TaskId);
 void Sch_Start(void);
 void Sch_Update(void);
 
@@ -0,0 +1,1085 @@
+/**
+ * @file sch_analyze.c
+ * @author Mohamed Hassanin
+ * @brief Host-side schedulability analysis of a static task set for the
+ *  cooperative scheduler, before it's deployed with Sch_AddTask.
+ *
+ *  It reports the utilization over the hyperperiod, the worst load of a
+ *  single tick, how long a release can wait behind earlier work (the
+ *  backlog of rounds that overran their tick and of tasks longer than a
+ *  tick) and, for every task, a bound on its response time and on its
+ *  release jitter, i.e. how late it may start after its tick.
+ *
+ *  The model is the POSIX scheduler with one instance and serial
+ *  dispatch: at every round the due tasks run once each, by priority then
+ *  in task id (line) order, none preempts another. The WCETs should
+ *  include the dispatch overhead. The bounds hold as long as no release
+ *  is missed, which is checked: every response bound must fit in the
+ *  task period.
+ *
+ *  No tick is enumerated over the hyperperiod, which may be huge: the
+ *  periods that share no prime factor are independent (Chinese remainder
+ *  theorem), so the periods are split in groups of related ones and the
+ *  per-tick load is only built over the LCM of each group, where a
+ *  period dividing the LCM of its group adds one entry per release. A
+ *  group whose LCM is longer than max_span ticks is bounded instead:
+ *  a release of a task can only coincide with the phases of another
+ *  period that are congruent to its own modulo their GCD.
+ *
+ *  Usage: sch_analyze [-t tick_ms] [-u max_util_pct] [-m max_span]
+ *                     [-k tasks] [-p levels] tasks.tbl
+ *    -t  the tick length, 10 ms by default
+ *    -u  the tick load allowed, in % of the tick, 100 by default
+ *    -m  the longest per-tick load profile, 1000000 ticks by default
+ *    -k  the tasks listed, the least slack relative to the period
+ *        first, 20 by default, 0 for all
+ *    -p  the priority levels, SCH_PRIORITIES, 1 by default
+ *
+ *  Every non empty line of the task file that isn't a # comment is:
+ *    <name> <delay> <period> [wcet_us [priority]]
+ *  as for tools/sch_table_gen, in Sch_AddTask order, the priority being
+ *  the one given to Sch_SetTaskPriority, 0 the highest. A task without
+ *  one has the lowest, levels - 1, as Sch_AddTask gives it.
+ *
+ *  The exit status is 0 when the task set fits: no tick loaded above
+ *  the limit, a bounded backlog and no missed release.
+ * @version 0.1
+ * @date 2021-03-04
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#define AN_MAX_TASKS 65535u
+#define AN_MAX_NAME 64u
+#define AN_MAX_SPAN 1000000ull /*< The default -m */
+#define AN_MAX_WINDOW 4096u /*< The longest backlog window examined, in ticks */
+#define AN_MAX_LEVELS 256u
+#define AN_MAX_FACTORS 9u /*< Distinct prime factors of a period below 2^32 */
+
+typedef unsigned __int128 AnWide_t;
+
+/**
+ * @brief One task of the task set and its results.
+ *
+ */
+typedef struct
+{
+  char Name[AN_MAX_NAME]; /*< The task function */
+  uint64_t Delay; /*< Ticks before the first run */
+  uint64_t Period; /*< Ticks between two runs */
+  uint64_t Phase; /*< The release ticks modulo the period */
+  uint64_t WcetUs; /*< Worst case execution time */
+  uint32_t Priority; /*< Dispatch priority, 0 is the highest */
+  uint32_t Level; /*< The rank of Priority among the ones used */
+  uint32_t Comp; /*< Its group of related periods */
+  uint64_t TickUs; /*< Worst load of its ticks at its priority and above, itself included */
+  uint64_t BlockUs; /*< Worst earlier work it may wait for */
+  uint64_t ResponseUs; /*< Response time bound from its tick */
+} AnTask_t;
+
+/**
+ * @brief The tasks of one period, contiguous in Order by phase.
+ *
+ */
+typedef struct
+{
+  uint64_t Period;
+  uint32_t First; /*< Its first task in Order */
+  uint32_t Count; /*< Its tasks */
+  uint32_t Comp; /*< Its group of related periods */
+  uint32_t FactorCount;
+  uint32_t Factors[AN_MAX_FACTORS]; /*< Its prime factors, ascending */
+  uint32_t Powers[AN_MAX_FACTORS]; /*< Their powers dividing the period */
+  uint64_t MaxUs; /*< Its heaviest phase, at the level being bounded */
+} AnGroup_t;
+
+/**
+ * @brief A group of periods related by a common prime factor.
+ *
+ */
+typedef struct
+{
+  AnWide_t Lcm; /*< The LCM of its periods, saturated */
+  uint64_t Span; /*< Length of its load profile, the LCM, 0 if too long: bounds only */
+  uint32_t FirstGroup; /*< Its first period in Groups */
+  uint32_t GroupCount; /*< Its periods */
+  uint64_t *Profile; /*< The load of every tick of the span, all priorities */
+  uint64_t WorstTick; /*< The tick of the span with the worst load */
+  uint64_t MaxUs[AN_MAX_LEVELS]; /*< The worst tick load of each level and above */
+} AnComp_t;
+
+/**
+ * @brief A prime factor of a period.
+ *
+ */
+typedef struct
+{
+  uint64_t Prime;
+  uint32_t Group; /*< The period, in Groups */
+} AnPrime_t;
+
+static AnTask_t *Tasks;
+static uint32_t TaskCount;
+static uint32_t *Order; /*< Task indexes, sorted */
+static AnGroup_t *Groups;
+static uint32_t GroupCount;
+static AnComp_t *Comps;
+static uint32_t CompCount;
+static uint32_t LevelCount;
+static uint64_t *Scratch; /*< A profile being built */
+
+static int ReadTasks(const char *Path, const uint32_t Levels);
+static void SetLevels(void);
+static int BuildComps(const uint64_t MaxSpan);
+static uint32_t Find(uint32_t *Parent, uint32_t Index);
+static int CompareTasks(const void *A, const void *B);
+static int ComparePrimes(const void *A, const void *B);
+static int CompareComps(const void *A, const void *B);
+static int CompareGroups(const void *A, const void *B);
+static int CompareSlack(const void *A, const void *B);
+static void BuildProfile(const AnComp_t *Comp, const uint32_t Level, uint64_t *Profile);
+static uint64_t BoundMax(const AnComp_t *Comp, const uint32_t Level);
+static uint64_t BoundAt(const AnComp_t *Comp, const AnGroup_t *Own, const AnTask_t *Task);
+static uint64_t Window(const AnComp_t *Comp, const uint64_t *Profile, const uint32_t Level,
+                       const uint64_t Ticks);
+static uint64_t Phases(const AnGroup_t *Group, const uint32_t Level, uint64_t *Max);
+static void Factor(AnGroup_t *Group);
+static uint64_t GroupGcd(const AnGroup_t *A, const AnGroup_t *B);
+static AnWide_t WideGcd(AnWide_t A, AnWide_t B);
+static int WorstTick(uint64_t *Tick);
+static void PrintTicks(const AnWide_t Ticks, const double TickMs);
+
+int main(int argc, char *argv[])
+{
+  double TickMs = 10.0, MaxUtil = 100.0;
+  uint64_t MaxSpan = AN_MAX_SPAN;
+  uint32_t Shown = 20, Levels = 1;
+  AnWide_t Hyper = 1;
+  uint64_t TickUs, TotalMax[AN_MAX_LEVELS] = { 0 }, Extra[AN_MAX_LEVELS] = { 0 };
+  uint64_t Backlog = 0, Ticks, Demand, Tick;
+  uint64_t LongestUs = 0, LongCount = 0, Missed = 0;
+  double Util = 0.0;
+  uint32_t Index, Level, CompId, Longest = 0;
+  int Option, Bounded = 1, Exact = 1, Status = EXIT_SUCCESS;
+
+  while ((Option = getopt(argc, argv, "t:u:m:k:p:")) != -1)
+    {
+      switch (Option)
+        {
+        case 't': TickMs = strtod(optarg, NULL); break;
+        case 'u': MaxUtil = strtod(optarg, NULL); break;
+        case 'm': MaxSpan = strtoull(optarg, NULL, 10); break;
+        case 'k': Shown = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'p': Levels = (uint32_t)strtoul(optarg, NULL, 10); break;
+        default:
+          fprintf(stderr, "usage: %s [-t tick_ms] [-u max_util_pct] [-m max_span] "
+                  "[-k tasks] [-p levels] tasks.tbl\n", argv[0]);
+          return EXIT_FAILURE;
+        }
+    }
+  if (optind != argc - 1 || TickMs <= 0 || MaxSpan == 0 || Levels == 0 ||
+      Levels > AN_MAX_LEVELS)
+    {
+      fprintf(stderr, "usage: %s [-t tick_ms] [-u max_util_pct] [-m max_span] "
+              "[-k tasks] [-p levels] tasks.tbl\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  TickUs = (uint64_t)(TickMs * 1000.0 + 0.5);
+  if (ReadTasks(argv[optind], Levels) != 0)
+    {
+      return EXIT_FAILURE;
+    }
+  SetLevels();
+  if (BuildComps(MaxSpan) != 0)
+    {
+      fprintf(stderr, "out of memory\n");
+      return EXIT_FAILURE;
+    }
+
+  // The worst tick load of every group, exact over its span or bounded
+  for (CompId = 0; CompId < CompCount; CompId++)
+    {
+      AnComp_t *Comp = &Comps[CompId];
+
+      for (Level = 0; Level < LevelCount; Level++)
+        {
+          if (Comp->Span == 0)
+            {
+              Comp->MaxUs[Level] = BoundMax(Comp, Level);
+              continue;
+            }
+          BuildProfile(Comp, Level, Scratch);
+          for (Tick = 0; Tick < Comp->Span; Tick++)
+            {
+              if (Scratch[Tick] > Comp->MaxUs[Level])
+                {
+                  Comp->MaxUs[Level] = Scratch[Tick];
+                  Comp->WorstTick = Tick;
+                }
+            }
+        }
+      if (Comp->Span != 0)
+        {
+          // The last level is every task, kept for the backlog windows
+          memcpy(Comp->Profile, Scratch, Comp->Span * sizeof(uint64_t));
+        }
+      else
+        {
+          Exact = 0;
+        }
+      for (Level = 0; Level < LevelCount; Level++)
+        {
+          TotalMax[Level] += Comp->MaxUs[Level];
+        }
+      Hyper = Hyper > ((AnWide_t)1 << 100) / Comp->Lcm ? (AnWide_t)1 << 100 : Hyper * Comp->Lcm;
+    }
+  for (Index = 0; Index < TaskCount; Index++)
+    {
+      Util += (double)Tasks[Index].WcetUs / ((double)Tasks[Index].Period * TickUs);
+      if (Tasks[Index].WcetUs > LongestUs)
+        {
+          LongestUs = Tasks[Index].WcetUs;
+          Longest = Index;
+        }
+      LongCount += Tasks[Index].WcetUs > TickUs;
+    }
+
+  /* The work released before a tick and not done when it comes is at most
+  the worst excess of the demand of consecutive ticks over their length.
+  Demand is subadditive, so the first window that fits ends the search */
+  if (TotalMax[LevelCount - 1] > TickUs)
+    {
+      Bounded = 0;
+      for (Ticks = 1; Ticks <= AN_MAX_WINDOW && Util < 1.0; Ticks++)
+        {
+          Demand = 0;
+          for (CompId = 0; CompId < CompCount; CompId++)
+            {
+              Demand += Window(&Comps[CompId], Comps[CompId].Profile, LevelCount - 1, Ticks);
+            }
+          if (Demand <= Ticks * TickUs)
+            {
+              Bounded = 1;
+              break;
+            }
+          Backlog = Demand - Ticks * TickUs > Backlog ? Demand - Ticks * TickUs : Backlog;
+        }
+    }
+
+  /* Per task: the worst load of its own ticks at its priority and above,
+  then the tasks ahead of it released while the backlog drains */
+  for (CompId = 0; CompId < CompCount; CompId++)
+    {
+      AnComp_t *Comp = &Comps[CompId];
+      uint32_t Group, Key;
+      uint64_t Worst = 0;
+
+      for (Level = 0; Level < LevelCount; Level++)
+        {
+          if (Comp->Span != 0)
+            {
+              BuildProfile(Comp, Level, Scratch);
+            }
+          for (Group = Comp->FirstGroup; Group < Comp->FirstGroup + Comp->GroupCount; Group++)
+            {
+              Phases(&Groups[Group], Level, &Groups[Group].MaxUs);
+            }
+          Extra[Level] += Window(Comp, Comp->Span != 0 ? Scratch : NULL, Level,
+                                 Backlog / TickUs);
+          for (Group = Comp->FirstGroup; Group < Comp->FirstGroup + Comp->GroupCount; Group++)
+            {
+              const uint32_t First = Groups[Group].First, End = First + Groups[Group].Count;
+
+              for (Key = First; Key < End; Key++)
+                {
+                  AnTask_t *Task = &Tasks[Order[Key]];
+
+                  if (Task->Level != Level)
+                    {
+                      continue;
+                    }
+                  // The tasks of the same phase and level share the result
+                  if (Key == First || CompareTasks(&Order[Key - 1], &Order[Key]) != 0)
+                    {
+                      if (Comp->Span == 0)
+                        {
+                          Worst = BoundAt(Comp, &Groups[Group], Task);
+                        }
+                      else
+                        {
+                          Worst = 0;
+                          for (Tick = Task->Phase; Tick < Comp->Span; Tick += Task->Period)
+                            {
+                              Worst = Scratch[Tick] > Worst ? Scratch[Tick] : Worst;
+                            }
+                        }
+                    }
+                  Task->TickUs = Worst + TotalMax[Level] - Comp->MaxUs[Level];
+                }
+            }
+        }
+    }
+  for (Index = 0; Index < TaskCount; Index++)
+    {
+      Tasks[Index].BlockUs = Backlog + (Backlog != 0 ? Extra[Tasks[Index].Level] : 0);
+      Tasks[Index].ResponseUs = Tasks[Index].BlockUs + Tasks[Index].TickUs;
+      Missed += Tasks[Index].ResponseUs > Tasks[Index].Period * TickUs;
+    }
+
+  printf("tasks %u, %u periods in %u independent group(s), hyperperiod ",
+         TaskCount, GroupCount, CompCount);
+  PrintTicks(Hyper, TickMs);
+  printf("\nutilization %.2f%% (mean tick load %.1f us)\n", 100.0 * Util, Util * TickUs);
+  printf("worst tick load %" PRIu64 " us (%.1f%% of a %.1f ms tick)",
+         TotalMax[LevelCount - 1], 100.0 * TotalMax[LevelCount - 1] / TickUs, TickMs);
+  if (Exact && WorstTick(&Tick) == 0)
+    {
+      printf(" at tick %" PRIu64 "\n", Tick);
+    }
+  else
+    {
+      printf(Exact ? "\n" : ", an upper bound (groups longer than %" PRIu64 " ticks)\n", MaxSpan);
+    }
+  printf("longest task %s %" PRIu64 " us, %" PRIu64 " longer than a tick\n",
+         Tasks[Longest].Name, LongestUs, LongCount);
+  if (!Bounded)
+    {
+      printf("backlog: unbounded within %u ticks\n", AN_MAX_WINDOW);
+    }
+  else if (Backlog == 0)
+    {
+      printf("backlog: none, every round ends within its tick\n");
+    }
+  else
+    {
+      printf("backlog: up to %" PRIu64 " us of earlier work left when a tick comes\n",
+             Backlog);
+    }
+
+  if (Shown == 0 || Shown > TaskCount)
+    {
+      Shown = TaskCount;
+    }
+  for (Index = 0; Index < TaskCount; Index++)
+    {
+      Order[Index] = Index;
+    }
+  qsort(Order, TaskCount, sizeof(Order[0]), CompareSlack);
+  printf("%6s %-20s %8s %9s %5s %10s %10s %10s %10s %11s\n", "ID", "NAME", "PERIOD",
+         "WCET_US", "PRIO", "TICK_US", "BLOCK_US", "RESP_US", "JITTER_US", "SLACK_US");
+  for (Index = 0; Index < Shown; Index++)
+    {
+      AnTask_t *Task = &Tasks[Order[Index]];
+
+      printf("%6u %-20s %8" PRIu64 " %9" PRIu64 " %5u %10" PRIu64, Order[Index], Task->Name,
+             Task->Period, Task->WcetUs, Task->Priority, Task->TickUs);
+      if (!Bounded)
+        {
+          // Only the load of its own ticks is known
+          printf(" %10s %10s %10s %11s\n", "-", "-", "-", "-");
+          continue;
+        }
+      printf(" %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %11" PRId64 "\n",
+             Task->BlockUs, Task->ResponseUs, Task->ResponseUs - Task->WcetUs,
+             (int64_t)(Task->Period * TickUs) - (int64_t)Task->ResponseUs);
+    }
+
+  if (100.0 * TotalMax[LevelCount - 1] / TickUs > MaxUtil)
+    {
+      fprintf(stderr, "a tick is overloaded: %" PRIu64 " us of work in a %.1f ms tick "
+              "(limit %.1f%%), move a task delay\n", TotalMax[LevelCount - 1], TickMs, MaxUtil);
+      Status = EXIT_FAILURE;
+    }
+  if (Util >= 1.0 || !Bounded)
+    {
+      fprintf(stderr, "the task set doesn't fit: the backlog grows without bound\n");
+      Status = EXIT_FAILURE;
+    }
+  else if (Missed != 0)
+    {
+      fprintf(stderr, "%" PRIu64 " task(s) may miss a release: the response bound "
+              "exceeds the period\n", Missed);
+      Status = EXIT_FAILURE;
+    }
+  return Status;
+}
+
+/**
+ * @brief Reads the task file.
+ *
+ * @param Path the task file.
+ * @param Levels the priority levels, a task without a priority gets
+ *  the lowest.
+ * @return int 0 on success, -1 on a malformed file.
+ */
+static int ReadTasks(const char *Path, const uint32_t Levels)
+{
+  FILE *In = fopen(Path, "r");
+  char Line[256];
+  uint32_t LineNumber = 0, Capacity = 0;
+  AnTask_t *Task;
+  int Fields;
+
+  if (In == NULL)
+    {
+      perror(Path);
+      return -1;
+    }
+  while (fgets(Line, sizeof(Line), In) != NULL)
+    {
+      LineNumber++;
+      Line[strcspn(Line, "#\n")] = '\0';
+      if (strspn(Line, " \t\r") == strlen(Line))
+        {
+          continue;
+        }
+      if (TaskCount == AN_MAX_TASKS)
+        {
+          fprintf(stderr, "%s:%u: more than %u tasks\n", Path, LineNumber, AN_MAX_TASKS);
+          fclose(In);
+          return -1;
+        }
+      if (TaskCount == Capacity)
+        {
+          Capacity = Capacity ? Capacity * 2 : 1024;
+          Tasks = realloc(Tasks, Capacity * sizeof(AnTask_t));
+          if (Tasks == NULL)
+            {
+              fprintf(stderr, "out of memory\n");
+              fclose(In);
+              return -1;
+            }
+        }
+      Task = &Tasks[TaskCount];
+      memset(Task, 0, sizeof(*Task));
+      Fields = sscanf(Line, "%63s %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu32,
+                      Task->Name, &Task->Delay, &Task->Period, &Task->WcetUs,
+                      &Task->Priority);
+      if (Fields < 5)
+        {
+          Task->Priority = Levels - 1;
+        }
+      if (Fields < 3 || Task->Period == 0 || Task->Period > UINT32_MAX ||
+          Task->Priority >= Levels)
+        {
+          fprintf(stderr, "%s:%u: expected <name> <delay> <period> [wcet_us [priority]] "
+                  "with 0 < period < 2^32 and priority < %u (-p)\n", Path, LineNumber,
+                  Levels);
+          fclose(In);
+          return -1;
+        }
+      // A later first release only skips some of the steady state ones
+      Task->Phase = Task->Delay % Task->Period;
+      TaskCount++;
+    }
+  fclose(In);
+
+  if (TaskCount == 0)
+    {
+      fprintf(stderr, "%s: no task\n", Path);
+      return -1;
+    }
+  Order = malloc(TaskCount * sizeof(uint32_t));
+  return Order != NULL ? 0 : -1;
+}
+
+/**
+ * @brief Numbers the priorities in use: level k holds the tasks of the
+ *  k-th highest one.
+ *
+ */
+static void SetLevels(void)
+{
+  uint8_t Used[AN_MAX_LEVELS] = { 0 };
+  uint32_t Index, Priority;
+
+  for (Index = 0; Index < TaskCount; Index++)
+    {
+      Used[Tasks[Index].Priority] = 1;
+    }
+  for (Priority = 0; Priority < AN_MAX_LEVELS; Priority++)
+    {
+      if (Used[Priority])
+        {
+          Used[Priority] = (uint8_t)LevelCount++;
+        }
+    }
+  for (Index = 0; Index < TaskCount; Index++)
+    {
+      Tasks[Index].Level = Used[Tasks[Index].Priority];
+    }
+}
+
+/**
+ * @brief Splits the periods in groups sharing a prime factor, computes
+ *  their LCM and allots the profile spans, the shortest groups first,
+ *  up to MaxSpan ticks in all. The tasks are then sorted by group,
+ *  period, phase and level.
+ *
+ * @return int 0 on success, -1 out of memory.
+ */
+static int BuildComps(const uint64_t MaxSpan)
+{
+  AnPrime_t *Primes;
+  uint32_t *Parent, *Rank, *Owner, *Member;
+  uint64_t Spent = 0, Largest = 1;
+  uint32_t Index, Group, PrimeCount = 0;
+  AnComp_t *Sorted;
+
+  for (Index = 0; Index < TaskCount; Index++)
+    {
+      Order[Index] = Index;
+    }
+  qsort(Order, TaskCount, sizeof(Order[0]), CompareTasks);
+
+  // The distinct periods
+  Groups = malloc(TaskCount * sizeof(AnGroup_t));
+  Parent = malloc(TaskCount * sizeof(uint32_t));
+  Owner = malloc(TaskCount * sizeof(uint32_t));
+  Member = malloc(TaskCount * sizeof(uint32_t));
+  Primes = malloc(TaskCount * AN_MAX_FACTORS * sizeof(AnPrime_t));
+  if (Groups == NULL || Parent == NULL || Owner == NULL || Member == NULL || Primes == NULL)
+    {
+      return -1;
+    }
+  for (Index = 0; Index < TaskCount; Index++)
+    {
+      if (Index == 0 || Tasks[Order[Index]].Period != Groups[GroupCount - 1].Period)
+        {
+          Groups[GroupCount].Period = Tasks[Order[Index]].Period;
+          Groups[GroupCount].First = Index;
+          Groups[GroupCount].Count = 0;
+          GroupCount++;
+        }
+      Groups[GroupCount - 1].Count++;
+    }
+  for (Group = 0; Group < GroupCount; Group++)
+    {
+      Parent[Group] = Group;
+      Factor(&Groups[Group]);
+      for (Index = 0; Index < Groups[Group].FactorCount; Index++)
+        {
+          Primes[PrimeCount].Prime = Groups[Group].Factors[Index];
+          Primes[PrimeCount++].Group = Group;
+        }
+    }
+
+  // The periods sharing a prime are one group
+  qsort(Primes, PrimeCount, sizeof(AnPrime_t), ComparePrimes);
+  for (Index = 1; Index < PrimeCount; Index++)
+    {
+      if (Primes[Index].Prime == Primes[Index - 1].Prime)
+        {
+          Parent[Find(Parent, Primes[Index].Group)] = Find(Parent, Primes[Index - 1].Group);
+        }
+    }
+  free(Primes);
+
+  Comps = calloc(GroupCount, sizeof(AnComp_t));
+  Sorted = calloc(GroupCount, sizeof(AnComp_t));
+  Rank = malloc(GroupCount * sizeof(uint32_t));
+  if (Comps == NULL || Sorted == NULL || Rank == NULL)
+    {
+      return -1;
+    }
+  for (Group = 0; Group < GroupCount; Group++)
+    {
+      Owner[Group] = UINT32_MAX;
+    }
+  for (Group = 0; Group < GroupCount; Group++)
+    {
+      AnComp_t *Comp;
+
+      Index = Find(Parent, Group);
+      if (Owner[Index] == UINT32_MAX)
+        {
+          Owner[Index] = CompCount;
+          Comps[CompCount++].Lcm = 1;
+        }
+      Member[Group] = Owner[Index];
+      Comp = &Comps[Member[Group]];
+      // Saturated far above any span, only printed as over 2^64 then
+      if (Comp->Lcm < ((AnWide_t)1 << 96))
+        {
+          Comp->Lcm = Comp->Lcm / WideGcd(Comp->Lcm, Groups[Group].Period) * Groups[Group].Period;
+        }
+    }
+
+  // The shortest spans first, so the most groups get an exact profile
+  for (Index = 0; Index < CompCount; Index++)
+    {
+      Rank[Index] = Index;
+    }
+  qsort(Rank, CompCount, sizeof(Rank[0]), CompareComps);
+  for (Index = 0; Index < CompCount; Index++)
+    {
+      Sorted[Index] = Comps[Rank[Index]];
+      Parent[Rank[Index]] = Index;
+      if (Sorted[Index].Lcm <= MaxSpan - Spent)
+        {
+          Sorted[Index].Span = (uint64_t)Sorted[Index].Lcm;
+          Spent += Sorted[Index].Span;
+          Largest = Sorted[Index].Span > Largest ? Sorted[Index].Span : Largest;
+          Sorted[Index].Profile = malloc(Sorted[Index].Span * sizeof(uint64_t));
+          if (Sorted[Index].Profile == NULL)
+            {
+              return -1;
+            }
+        }
+    }
+  free(Comps);
+  Comps = Sorted;
+  for (Group = 0; Group < GroupCount; Group++)
+    {
+      Groups[Group].Comp = Parent[Member[Group]];
+      for (Index = 0; Index < Groups[Group].Count; Index++)
+        {
+          Tasks[Order[Groups[Group].First + Index]].Comp = Groups[Group].Comp;
+        }
+    }
+  free(Rank);
+  free(Member);
+  free(Owner);
+  free(Parent);
+  Scratch = malloc(Largest * sizeof(uint64_t));
+  if (Scratch == NULL)
+    {
+      return -1;
+    }
+
+  // The tasks and the periods, now contiguous per comp
+  qsort(Order, TaskCount, sizeof(Order[0]), CompareTasks);
+  qsort(Groups, GroupCount, sizeof(AnGroup_t), CompareGroups);
+  for (Group = 0, Index = 0; Group < GroupCount; Group++)
+    {
+      if (Comps[Groups[Group].Comp].GroupCount++ == 0)
+        {
+          Comps[Groups[Group].Comp].FirstGroup = Group;
+        }
+      Groups[Group].First = Index;
+      Index += Groups[Group].Count;
+    }
+  return 0;
+}
+
+/**
+ * @brief The root of a union-find set, with path halving.
+ *
+ */
+static uint32_t Find(uint32_t *Parent, uint32_t Index)
+{
+  while (Parent[Index] != Index)
+    {
+      Parent[Index] = Parent[Parent[Index]];
+      Index = Parent[Index];
+    }
+  return Index;
+}
+
+/**
+ * @brief qsort order of the tasks: group, period, phase, level.
+ *
+ */
+static int CompareTasks(const void *A, const void *B)
+{
+  const AnTask_t *TaskA = &Tasks[*(const uint32_t *)A];
+  const AnTask_t *TaskB = &Tasks[*(const uint32_t *)B];
+
+  if (TaskA->Comp != TaskB->Comp)
+    {
+      return TaskA->Comp < TaskB->Comp ? -1 : 1;
+    }
+  if (TaskA->Period != TaskB->Period)
+    {
+      return TaskA->Period < TaskB->Period ? -1 : 1;
+    }
+  if (TaskA->Phase != TaskB->Phase)
+    {
+      return TaskA->Phase < TaskB->Phase ? -1 : 1;
+    }
+  if (TaskA->Level != TaskB->Level)
+    {
+      return TaskA->Level < TaskB->Level ? -1 : 1;
+    }
+  return 0;
+}
+
+/**
+ * @brief qsort order of the prime factors.
+ *
+ */
+static int ComparePrimes(const void *A, const void *B)
+{
+  const AnPrime_t *PrimeA = A, *PrimeB = B;
+
+  if (PrimeA->Prime != PrimeB->Prime)
+    {
+      return PrimeA->Prime < PrimeB->Prime ? -1 : 1;
+    }
+  return PrimeA->Group < PrimeB->Group ? -1 : PrimeA->Group > PrimeB->Group;
+}
+
+/**
+ * @brief qsort order of the groups: the shortest LCM first.
+ *
+ */
+static int CompareComps(const void *A, const void *B)
+{
+  const AnComp_t *CompA = &Comps[*(const uint32_t *)A];
+  const AnComp_t *CompB = &Comps[*(const uint32_t *)B];
+
+  if (CompA->Lcm != CompB->Lcm)
+    {
+      return CompA->Lcm < CompB->Lcm ? -1 : 1;
+    }
+  return *(const uint32_t *)A < *(const uint32_t *)B ? -1 : 1;
+}
+
+/**
+ * @brief qsort order of the periods: group, period.
+ *
+ */
+static int CompareGroups(const void *A, const void *B)
+{
+  const AnGroup_t *GroupA = A, *GroupB = B;
+
+  if (GroupA->Comp != GroupB->Comp)
+    {
+      return GroupA->Comp < GroupB->Comp ? -1 : 1;
+    }
+  return GroupA->Period < GroupB->Period ? -1 : GroupA->Period > GroupB->Period;
+}
+
+/**
+ * @brief qsort order of the report: the largest share of the period
+ *  taken by the response bound first, then the line order.
+ *
+ */
+static int CompareSlack(const void *A, const void *B)
+{
+  const uint32_t IndexA = *(const uint32_t *)A, IndexB = *(const uint32_t *)B;
+  const double ShareA = (double)Tasks[IndexA].ResponseUs / Tasks[IndexA].Period;
+  const double ShareB = (double)Tasks[IndexB].ResponseUs / Tasks[IndexB].Period;
+
+  if (ShareA != ShareB)
+    {
+      return ShareA > ShareB ? -1 : 1;
+    }
+  return IndexA < IndexB ? -1 : 1;
+}
+
+/**
+ * @brief Builds the load of every tick of the span of a group, counting
+ *  the tasks of Level and above: one entry per release of each phase.
+ *
+ */
+static void BuildProfile(const AnComp_t *Comp, const uint32_t Level, uint64_t *Profile)
+{
+  const AnGroup_t *Group;
+  const AnTask_t *Task;
+  uint64_t Weight, Tick;
+  uint32_t Index, Key;
+
+  memset(Profile, 0, Comp->Span * sizeof(uint64_t));
+  for (Index = 0; Index < Comp->GroupCount; Index++)
+    {
+      Group = &Groups[Comp->FirstGroup + Index];
+      for (Key = Group->First; Key < Group->First + Group->Count; Key += 0)
+        {
+          // Every task of the same phase at once
+          Task = &Tasks[Order[Key]];
+          Weight = 0;
+          for (; Key < Group->First + Group->Count && Tasks[Order[Key]].Phase == Task->Phase; Key++)
+            {
+              Weight += Tasks[Order[Key]].Level <= Level ? Tasks[Order[Key]].WcetUs : 0;
+            }
+          for (Tick = Task->Phase; Weight != 0 && Tick < Comp->Span; Tick += Group->Period)
+            {
+              Profile[Tick] += Weight;
+            }
+        }
+    }
+}
+
+/**
+ * @brief The load of every phase of a period, Level and above: returns
+ *  the sum and sets Max to the heaviest phase.
+ *
+ */
+static uint64_t Phases(const AnGroup_t *Group, const uint32_t Level, uint64_t *Max)
+{
+  uint64_t Sum = 0, Weight = 0;
+  uint32_t Key;
+
+  *Max = 0;
+  for (Key = Group->First; Key < Group->First + Group->Count; Key++)
+    {
+      if (Key > Group->First && Tasks[Order[Key]].Phase != Tasks[Order[Key - 1]].Phase)
+        {
+          Weight = 0;
+        }
+      Weight += Tasks[Order[Key]].Level <= Level ? Tasks[Order[Key]].WcetUs : 0;
+      Sum += Tasks[Order[Key]].Level <= Level ? Tasks[Order[Key]].WcetUs : 0;
+      *Max = Weight > *Max ? Weight : *Max;
+    }
+  return Sum;
+}
+
+/**
+ * @brief A bound on the worst tick load of a group without a profile:
+ *  the heaviest phase of each of its periods.
+ *
+ */
+static uint64_t BoundMax(const AnComp_t *Comp, const uint32_t Level)
+{
+  uint64_t Total = 0, Max;
+  uint32_t Index;
+
+  for (Index = 0; Index < Comp->GroupCount; Index++)
+    {
+      Phases(&Groups[Comp->FirstGroup + Index], Level, &Max);
+      Total += Max;
+    }
+  return Total;
+}
+
+/**
+ * @brief A bound on the worst load of the ticks a task is released at,
+ *  in a group without a profile: of every other period, the heaviest
+ *  phase that can coincide with the task phase, i.e. congruent to it
+ *  modulo the GCD of the two periods.
+ *
+ */
+static uint64_t BoundAt(const AnComp_t *Comp, const AnGroup_t *Own, const AnTask_t *Task)
+{
+  const AnGroup_t *Group;
+  const AnTask_t *Other;
+  uint64_t Total = 0, Max, Weight, Divisor;
+  uint32_t Index, Key;
+
+  for (Index = 0; Index < Comp->GroupCount; Index++)
+    {
+      Group = &Groups[Comp->FirstGroup + Index];
+      Divisor = GroupGcd(Group, Own);
+      if (Divisor == 1)
+        {
+          // Any phase can coincide
+          Total += Group->MaxUs;
+          continue;
+        }
+      Max = 0;
+      Weight = 0;
+      for (Key = Group->First; Key < Group->First + Group->Count; Key++)
+        {
+          Other = &Tasks[Order[Key]];
+          if (Key > Group->First && Other->Phase != Tasks[Order[Key - 1]].Phase)
+            {
+              Weight = 0;
+            }
+          if (Other->Phase % Divisor == Task->Phase % Divisor && Other->Level <= Task->Level)
+            {
+              Weight += Other->WcetUs;
+              Max = Weight > Max ? Weight : Max;
+            }
+        }
+      Total += Max;
+    }
+  return Total;
+}
+
+/**
+ * @brief The worst load released in Ticks consecutive ticks of a group,
+ *  Level and above: over its profile when it has one, else bounded per
+ *  period (each phase is released at most ceil(Ticks / Period) times).
+ *
+ */
+static uint64_t Window(const AnComp_t *Comp, const uint64_t *Profile, const uint32_t Level,
+                       const uint64_t Ticks)
+{
+  uint64_t Sum, Max, Worst = 0, Tick, Whole, Rest;
+  uint32_t Index;
+
+  if (Ticks == 0)
+    {
+      return 0;
+    }
+  if (Comp->Span == 0 || Profile == NULL)
+    {
+      for (Index = 0; Index < Comp->GroupCount; Index++)
+        {
+          const AnGroup_t *Group = &Groups[Comp->FirstGroup + Index];
+
+          Sum = Phases(Group, Level, &Max);
+          Whole = (Ticks + Group->Period - 1) / Group->Period * Sum;
+          Worst += Whole < Ticks * Max ? Whole : Ticks * Max;
+        }
+      return Worst;
+    }
+
+  // Whole spans, then the heaviest circular window of the rest
+  Whole = 0;
+  Rest = Ticks % Comp->Span;
+  if (Ticks >= Comp->Span)
+    {
+      for (Sum = 0, Tick = 0; Tick < Comp->Span; Tick++)
+        {
+          Sum += Profile[Tick];
+        }
+      Whole = Ticks / Comp->Span * Sum;
+    }
+  if (Rest == 0)
+    {
+      return Whole;
+    }
+  for (Sum = 0, Tick = 0; Tick < Rest; Tick++)
+    {
+      Sum += Profile[Tick];
+    }
+  Worst = Sum;
+  for (Tick = 0; Tick < Comp->Span - Rest; Tick++)
+    {
+      Sum += Profile[Tick + Rest] - Profile[Tick];
+      Worst = Sum > Worst ? Sum : Worst;
+    }
+  for (; Tick < Comp->Span; Tick++)
+    {
+      Sum += Profile[Tick + Rest - Comp->Span] - Profile[Tick];
+      Worst = Sum > Worst ? Sum : Worst;
+    }
+  return Whole + Worst;
+}
+
+/**
+ * @brief Factors the period of a group by trial division.
+ *
+ */
+static void Factor(AnGroup_t *Group)
+{
+  uint64_t Rest = Group->Period, Divisor, Power;
+
+  Group->FactorCount = 0;
+  for (Divisor = 2; Divisor * Divisor <= Rest; Divisor += Divisor == 2 ? 1 : 2)
+    {
+      if (Rest % Divisor == 0)
+        {
+          for (Power = 1; Rest % Divisor == 0; Rest /= Divisor)
+            {
+              Power *= Divisor;
+            }
+          Group->Factors[Group->FactorCount] = (uint32_t)Divisor;
+          Group->Powers[Group->FactorCount++] = (uint32_t)Power;
+        }
+    }
+  if (Rest > 1)
+    {
+      Group->Factors[Group->FactorCount] = (uint32_t)Rest;
+      Group->Powers[Group->FactorCount++] = (uint32_t)Rest;
+    }
+}
+
+/**
+ * @brief The greatest common divisor of two periods, from their factors:
+ *  the bounds take one per pair of periods.
+ *
+ */
+static uint64_t GroupGcd(const AnGroup_t *A, const AnGroup_t *B)
+{
+  uint64_t Divisor = 1;
+  uint32_t IndexA = 0, IndexB = 0;
+
+  while (IndexA < A->FactorCount && IndexB < B->FactorCount)
+    {
+      if (A->Factors[IndexA] < B->Factors[IndexB])
+        {
+          IndexA++;
+        }
+      else if (A->Factors[IndexA] > B->Factors[IndexB])
+        {
+          IndexB++;
+        }
+      else
+        {
+          Divisor *= A->Powers[IndexA] < B->Powers[IndexB] ? A->Powers[IndexA] : B->Powers[IndexB];
+          IndexA++;
+          IndexB++;
+        }
+    }
+  return Divisor;
+}
+
+/**
+ * @brief The greatest common divisor of 128-bit LCMs.
+ *
+ */
+static AnWide_t WideGcd(AnWide_t A, AnWide_t B)
+{
+  AnWide_t Rest;
+
+  while (B != 0)
+    {
+      Rest = A % B;
+      A = B;
+      B = Rest;
+    }
+  return A;
+}
+
+/**
+ * @brief Combines the worst tick of every group into a tick of the
+ *  hyperperiod (Chinese remainder theorem, the group LCMs are coprime).
+ *
+ * @return int 0, or -1 if the hyperperiod doesn't fit 64 bits.
+ */
+static int WorstTick(uint64_t *Tick)
+{
+  AnWide_t Modulus = 1, Value = 0, Step, Inverse;
+  __int128 A, B, X0, X1, Quotient, Swap;
+  uint32_t CompId;
+
+  for (CompId = 0; CompId < CompCount; CompId++)
+    {
+      const AnComp_t *Comp = &Comps[CompId];
+
+      if (Modulus > UINT64_MAX / Comp->Lcm)
+        {
+          return -1;
+        }
+      // The inverse of Modulus modulo the group LCM, extended Euclid
+      A = (__int128)(Modulus % Comp->Lcm);
+      B = (__int128)Comp->Lcm;
+      X0 = 1;
+      X1 = 0;
+      while (B != 0)
+        {
+          Quotient = A / B;
+          Swap = A - Quotient * B; A = B; B = Swap;
+          Swap = X0 - Quotient * X1; X0 = X1; X1 = Swap;
+        }
+      Inverse = (AnWide_t)((X0 % (__int128)Comp->Lcm + (__int128)Comp->Lcm) % (__int128)Comp->Lcm);
+      Step = ((Comp->WorstTick + Comp->Lcm - Value % Comp->Lcm) % Comp->Lcm) * Inverse % Comp->Lcm;
+      Value += Modulus * Step;
+      Modulus *= Comp->Lcm;
+    }
+  *Tick = (uint64_t)Value;
+  return 0;
+}
+
+/**
+ * @brief Prints a tick count and its duration.
+ *
+ */
+static void PrintTicks(const AnWide_t Ticks, const double TickMs)
+{
+  if (Ticks > UINT64_MAX)
+    {
+      printf("over 2^64 ticks");
+      return;
+    }
+  printf("%" PRIu64 " ticks (%.1f s)", (uint64_t)Ticks, (double)(uint64_t)Ticks * TickMs / 1e3);
+}
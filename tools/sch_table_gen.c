@@ -0,0 +1,345 @@
+/**
+ * @file sch_table_gen.c
+ * @author Mohamed Hassanin
+ * @brief Host-side generator of static schedule tables.
+ *
+ *  It reads a static task set, computes its hyperperiod (the LCM of the
+ *  periods) and writes a header with a const table "tick -> due tasks"
+ *  covering the whole hyperperiod, for the table-driven dispatch mode of
+ *  the scheduler (SCH_ENGINE_TABLE on POSIX, SCH_STATIC_TABLE on the
+ *  other variants). Up to 32 tasks a tick is a bitmask of task ids,
+ *  above it is a list of task ids.
+ *
+ *  It also reports the utilization of every tick from the task WCETs,
+ *  and rejects the task set when a tick is loaded above the limit.
+ *
+ *  Usage: sch_table_gen [-t tick_ms] [-u max_util_pct] [-o out.h] tasks.tbl
+ *
+ *  Every non empty line of the task file that isn't a # comment is:
+ *    <name> <delay> <period> [wcet_us]
+ *  The task ids are the line order, which must be the Sch_AddTask order.
+ *  The delay must be less than the period.
+ * @version 0.1
+ * @date 2021-03-04
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#define GEN_MAX_TASKS 1024u
+#define GEN_MAX_NAME 64u
+#define GEN_MAX_LENGTH 1000000ull /*< The longest table accepted, in ticks */
+#define GEN_MASK_TASKS 32u /*< Above it the table is a list of ids */
+
+/**
+ * @brief One task of the static task set.
+ *
+ */
+typedef struct
+{
+  char Name[GEN_MAX_NAME]; /*< The task function */
+  uint64_t Delay; /*< Ticks before the first run */
+  uint64_t Period; /*< Ticks between two runs */
+  uint64_t WcetUs; /*< Worst case execution time, 0 if unknown */
+} GenTask_t;
+
+static GenTask_t Tasks[GEN_MAX_TASKS];
+static uint32_t TaskCount;
+
+static int ReadTasks(const char *Path);
+static uint64_t Gcd(uint64_t A, uint64_t B);
+static int IsDue(const GenTask_t *Task, const uint64_t Tick);
+static void WriteTable(FILE *Out, const char *Source, const uint64_t Length);
+
+int main(int argc, char *argv[])
+{
+  double TickMs = 10.0;
+  double MaxUtil = 100.0;
+  const char *OutPath = "sch_table.h";
+  uint64_t Length = 1;
+  uint64_t Tick, WorstTick = 0;
+  uint64_t LoadUs, WorstUs = 0, TotalUs = 0;
+  uint32_t Index;
+  int Option;
+  FILE *Out;
+
+  while ((Option = getopt(argc, argv, "t:u:o:")) != -1)
+    {
+      switch (Option)
+        {
+        case 't': TickMs = strtod(optarg, NULL); break;
+        case 'u': MaxUtil = strtod(optarg, NULL); break;
+        case 'o': OutPath = optarg; break;
+        default:
+          fprintf(stderr, "usage: %s [-t tick_ms] [-u max_util_pct] "
+                  "[-o out.h] tasks.tbl\n", argv[0]);
+          return EXIT_FAILURE;
+        }
+    }
+  if (optind >= argc || TickMs <= 0)
+    {
+      fprintf(stderr, "usage: %s [-t tick_ms] [-u max_util_pct] "
+              "[-o out.h] tasks.tbl\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  if (ReadTasks(argv[optind]) != 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  // The hyperperiod
+  for (Index = 0; Index < TaskCount; Index++)
+    {
+      Length = Length / Gcd(Length, Tasks[Index].Period) * Tasks[Index].Period;
+      if (Length > GEN_MAX_LENGTH)
+        {
+          fprintf(stderr, "the hyperperiod exceeds %llu ticks, use harmonic "
+                  "periods\n", (unsigned long long)GEN_MAX_LENGTH);
+          return EXIT_FAILURE;
+        }
+    }
+
+  // The tick utilization
+  for (Tick = 0; Tick < Length; Tick++)
+    {
+      LoadUs = 0;
+      for (Index = 0; Index < TaskCount; Index++)
+        {
+          if (IsDue(&Tasks[Index], Tick))
+            {
+              LoadUs += Tasks[Index].WcetUs;
+            }
+        }
+      TotalUs += LoadUs;
+      if (LoadUs > WorstUs)
+        {
+          WorstUs = LoadUs;
+          WorstTick = Tick;
+        }
+    }
+  printf("tasks %u, hyperperiod %llu ticks (%.1f ms)\n", TaskCount,
+         (unsigned long long)Length, Length * TickMs);
+  printf("tick utilization: mean %.1f%%, worst %.1f%% at tick %llu\n",
+         TotalUs / 10.0 / TickMs / Length, WorstUs / 10.0 / TickMs,
+         (unsigned long long)WorstTick);
+  if (WorstUs / 10.0 / TickMs > MaxUtil)
+    {
+      fprintf(stderr, "tick %llu is overloaded: %llu us of work in a %.1f ms "
+              "tick (limit %.1f%%), move a task delay\n",
+              (unsigned long long)WorstTick, (unsigned long long)WorstUs,
+              TickMs, MaxUtil);
+      return EXIT_FAILURE;
+    }
+
+  Out = fopen(OutPath, "w");
+  if (Out == NULL)
+    {
+      perror(OutPath);
+      return EXIT_FAILURE;
+    }
+  WriteTable(Out, argv[optind], Length);
+  fclose(Out);
+  printf("wrote %s\n", OutPath);
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Reads the task file.
+ *
+ * @param Path the task file.
+ * @return int 0 on success, -1 on a malformed file.
+ */
+static int ReadTasks(const char *Path)
+{
+  FILE *In = fopen(Path, "r");
+  char Line[256];
+  uint32_t LineNumber = 0;
+  GenTask_t *Task;
+  int Fields;
+
+  if (In == NULL)
+    {
+      perror(Path);
+      return -1;
+    }
+  while (fgets(Line, sizeof(Line), In) != NULL)
+    {
+      LineNumber++;
+      Line[strcspn(Line, "#\n")] = '\0';
+      if (strspn(Line, " \t\r") == strlen(Line))
+        {
+          continue;
+        }
+      if (TaskCount == GEN_MAX_TASKS)
+        {
+          fprintf(stderr, "%s:%u: more than %u tasks\n", Path, LineNumber,
+                  GEN_MAX_TASKS);
+          fclose(In);
+          return -1;
+        }
+      Task = &Tasks[TaskCount];
+      Task->WcetUs = 0;
+      Fields = sscanf(Line, "%63s %" SCNu64 " %" SCNu64 " %" SCNu64,
+                      Task->Name, &Task->Delay, &Task->Period, &Task->WcetUs);
+      if (Fields < 3 || Task->Period == 0 || Task->Delay >= Task->Period)
+        {
+          fprintf(stderr, "%s:%u: expected <name> <delay> <period> [wcet_us] "
+                  "with 0 <= delay < period\n", Path, LineNumber);
+          fclose(In);
+          return -1;
+        }
+      TaskCount++;
+    }
+  fclose(In);
+
+  if (TaskCount == 0)
+    {
+      fprintf(stderr, "%s: no task\n", Path);
+      return -1;
+    }
+  return 0;
+}
+
+/**
+ * @brief The greatest common divisor.
+ *
+ */
+static uint64_t Gcd(uint64_t A, uint64_t B)
+{
+  uint64_t Rest;
+
+  while (B != 0)
+    {
+      Rest = A % B;
+      A = B;
+      B = Rest;
+    }
+  return A;
+}
+
+/**
+ * @brief Whether a task is released at a tick of the hyperperiod.
+ *  As the delay is less than the period, the release ticks are the ones
+ *  congruent to the delay from tick 0 on.
+ *
+ */
+static int IsDue(const GenTask_t *Task, const uint64_t Tick)
+{
+  return Tick % Task->Period == Task->Delay;
+}
+
+/**
+ * @brief Writes the schedule table header.
+ *
+ * @param Out the header file.
+ * @param Source the task file, quoted in the header.
+ * @param Length the hyperperiod in ticks.
+ */
+static void WriteTable(FILE *Out, const char *Source, const uint64_t Length)
+{
+  const char *MaskType = TaskCount <= 8 ? "uint8_t" :
+                         TaskCount <= 16 ? "uint16_t" : "uint32_t";
+  uint64_t Tick, Count = 0;
+  uint32_t Index;
+  uint32_t Mask;
+
+  fprintf(Out, "/**\n * @file sch_table.h\n"
+          " * @brief Static schedule table generated by sch_table_gen from "
+          "%s.\n *  Don't edit it, edit the task file and generate it again.\n"
+          " */\n", Source);
+  fprintf(Out, "#ifndef SCH_TABLE_H\n#define SCH_TABLE_H\n\n");
+  fprintf(Out, "/* The variant may place the tables in flash and read them "
+          "back with SCH_TABLE_READ */\n#ifndef SCH_TABLE_STORAGE\n"
+          "#define SCH_TABLE_STORAGE\n"
+          "#define SCH_TABLE_READ(Dest, Src) ((Dest) = (Src))\n#endif\n\n");
+  fprintf(Out, "/*< The hyperperiod in ticks */\n#define SCH_TABLE_LENGTH %lluu\n",
+          (unsigned long long)Length);
+  fprintf(Out, "/*< The number of tasks */\n#define SCH_TABLE_TASKS %uu\n\n",
+          TaskCount);
+
+  fprintf(Out, "/* Task ids, in Sch_AddTask order:\n");
+  for (Index = 0; Index < TaskCount; Index++)
+    {
+      fprintf(Out, " *  %u %s delay %llu period %llu wcet %llu us\n", Index,
+              Tasks[Index].Name, (unsigned long long)Tasks[Index].Delay,
+              (unsigned long long)Tasks[Index].Period,
+              (unsigned long long)Tasks[Index].WcetUs);
+    }
+  fprintf(Out, " */\nstatic const Sch_Tick_t SCH_TABLE_STORAGE "
+          "SchTableDelay[SCH_TABLE_TASKS] =\n{\n");
+  for (Index = 0; Index < TaskCount; Index++)
+    {
+      fprintf(Out, "  %llu,\n", (unsigned long long)Tasks[Index].Delay);
+    }
+  fprintf(Out, "};\nstatic const Sch_Tick_t SCH_TABLE_STORAGE "
+          "SchTablePeriod[SCH_TABLE_TASKS] =\n{\n");
+  for (Index = 0; Index < TaskCount; Index++)
+    {
+      fprintf(Out, "  %llu,\n", (unsigned long long)Tasks[Index].Period);
+    }
+  fprintf(Out, "};\n\n");
+
+  if (TaskCount <= GEN_MASK_TASKS)
+    {
+      fprintf(Out, "/*< Bit i of SchTable[Tick] is set when task i is due */\n"
+              "#define SCH_TABLE_MASK_TYPE %s\n"
+              "static const SCH_TABLE_MASK_TYPE SCH_TABLE_STORAGE "
+              "SchTable[SCH_TABLE_LENGTH] =\n{\n", MaskType);
+      for (Tick = 0; Tick < Length; Tick++)
+        {
+          Mask = 0;
+          for (Index = 0; Index < TaskCount; Index++)
+            {
+              if (IsDue(&Tasks[Index], Tick))
+                {
+                  Mask |= 1ul << Index;
+                }
+            }
+          fprintf(Out, "%s0x%" PRIx32 ",%s", Tick % 8 ? "" : "  ", Mask,
+                  Tick % 8 == 7 || Tick == Length - 1 ? "\n" : " ");
+        }
+      fprintf(Out, "};\n");
+    }
+  else
+    {
+      fprintf(Out, "/*< The ids due at Tick are SchTableIds[SchTableStart[Tick]]"
+              " up to SchTableIds[SchTableStart[Tick + 1]] excluded */\n"
+              "#define SCH_TABLE_LIST 1\n"
+              "static const uint32_t SCH_TABLE_STORAGE "
+              "SchTableStart[SCH_TABLE_LENGTH + 1] =\n{\n");
+      for (Tick = 0; Tick <= Length; Tick++)
+        {
+          fprintf(Out, "%s%llu,%s", Tick % 8 ? "" : "  ",
+                  (unsigned long long)Count,
+                  Tick % 8 == 7 || Tick == Length ? "\n" : " ");
+          for (Index = 0; Tick < Length && Index < TaskCount; Index++)
+            {
+              Count += IsDue(&Tasks[Index], Tick);
+            }
+        }
+      fprintf(Out, "};\nstatic const Sch_TaskId_t SCH_TABLE_STORAGE "
+              "SchTableIds[%llu] =\n{\n", (unsigned long long)(Count ? Count : 1));
+      Count = 0;
+      for (Tick = 0; Tick < Length; Tick++)
+        {
+          for (Index = 0; Index < TaskCount; Index++)
+            {
+              if (IsDue(&Tasks[Index], Tick))
+                {
+                  fprintf(Out, "%s%u,%s", Count % 8 ? "" : "  ", Index,
+                          Count % 8 == 7 ? "\n" : " ");
+                  Count++;
+                }
+            }
+        }
+      fprintf(Out, "%s};\n", Count % 8 ? "\n" : "");
+    }
+
+  fprintf(Out, "\n#endif /* end SCH_TABLE_H */\n");
+}
@@ -0,0 +1,293 @@
+/**
+ * @file sch_top.c
+ * @author Mohamed Hassanin
+ * @brief Live top-style viewer of the statistics segment of a scheduler
+ *  process (SCH_SHM, see Sch_ShmOpen and POSIX/sch_shm.h).
+ *
+ *  It maps the segment read-only, so the watched process never notices
+ *  it: every sample is a sequence-locked copy of the entries, and the
+ *  rates are the differences between two samples.
+ *
+ *  Usage: sch_top [-i interval_ms] [-n samples] [-k tasks] [-b] name
+ *    -i  time between two samples, 1000 ms by default
+ *    -n  stop after that many samples, 0 (the default) runs forever
+ *    -k  the tasks shown per core, busiest first, 20 by default
+ *    -b  batch mode: no screen clearing, for logs and pipes
+ * @version 0.1
+ * @date 2021-03-04
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../POSIX/sch_shm.h"
+
+#define TOP_READ_TRIES 1000u /*< Sequence lock retries before a stale entry is kept */
+
+/**
+ * @brief One task row of a sample.
+ *
+ */
+typedef struct
+{
+  uint32_t TaskId;
+  Sch_ShmTask_t Now; /*< This sample */
+  uint64_t Releases; /*< Releases since the previous sample */
+  uint64_t Dispatches; /*< Runs since the previous sample */
+  uint64_t BusyNs; /*< Run time since the previous sample */
+} TopRow_t;
+
+static const Sch_ShmHeader_t *Header;
+static const uint8_t *Cores; /*< The core entries of the segment */
+static const uint8_t *Tasks; /*< The task entries of the segment */
+static Sch_ShmCore_t *PrevCores; /*< The previous sample */
+static Sch_ShmTask_t *PrevTasks;
+static TopRow_t *Rows;
+
+static int Attach(const char *Name);
+static void Sample(const double Seconds, const uint32_t Shown);
+static int CompareRows(const void *A, const void *B);
+static double NowSec(void);
+
+int main(int argc, char *argv[])
+{
+  uint32_t IntervalMs = 1000;
+  uint32_t Samples = 0, Shown = 20, Count;
+  int Batch = 0, Option;
+  double Last, Now;
+
+  while ((Option = getopt(argc, argv, "i:n:k:b")) != -1)
+    {
+      switch (Option)
+        {
+        case 'i': IntervalMs = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'n': Samples = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'k': Shown = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'b': Batch = 1; break;
+        default:
+          fprintf(stderr, "usage: %s [-i interval_ms] [-n samples] "
+                  "[-k tasks] [-b] name\n", argv[0]);
+          return EXIT_FAILURE;
+        }
+    }
+  if (optind != argc - 1 || IntervalMs == 0)
+    {
+      fprintf(stderr, "usage: %s [-i interval_ms] [-n samples] "
+              "[-k tasks] [-b] name\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  if (Attach(argv[optind]) != 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  // The first sample only sets the baseline of the rates
+  Last = NowSec();
+  Sample(0.0, 0);
+  for (Count = 0; Samples == 0 || Count < Samples; Count++)
+    {
+      usleep(IntervalMs * 1000u);
+      Now = NowSec();
+      if (!Batch)
+        {
+          printf("\033[H\033[J");
+        }
+      Sample(Now - Last, Shown);
+      fflush(stdout);
+      Last = Now;
+    }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Map the segment read-only and check its layout.
+ *
+ * @param Name the shared memory object name given to Sch_ShmOpen.
+ *
+ * @return int 0 on success, -1 otherwise.
+ */
+static int Attach(const char *Name)
+{
+  struct stat Info;
+  uint32_t Entries;
+  void *Map;
+  int Fd = shm_open(Name, O_RDONLY, 0);
+
+  if (Fd == -1 || fstat(Fd, &Info) == -1)
+    {
+      perror(Name);
+      return -1;
+    }
+  if ((size_t)Info.st_size < sizeof(Sch_ShmHeader_t))
+    {
+      fprintf(stderr, "%s: not a scheduler segment\n", Name);
+      return -1;
+    }
+  Map = mmap(NULL, (size_t)Info.st_size, PROT_READ, MAP_SHARED, Fd, 0);
+  close(Fd);
+  if (Map == MAP_FAILED)
+    {
+      perror("mmap");
+      return -1;
+    }
+  Header = Map;
+  if (__atomic_load_n(&Header->Magic, __ATOMIC_ACQUIRE) != SCH_SHM_MAGIC ||
+      Header->Version != SCH_SHM_VERSION ||
+      Header->CoreSize < sizeof(Sch_ShmCore_t) ||
+      Header->TaskSize < sizeof(Sch_ShmTask_t) ||
+      Header->Size > (uint64_t)Info.st_size ||
+      sizeof(Sch_ShmHeader_t) + (uint64_t)Header->Cores * Header->CoreSize +
+      (uint64_t)Header->Cores * Header->MaxTasks * Header->TaskSize > Header->Size)
+    {
+      fprintf(stderr, "%s: not a version %u scheduler segment\n", Name, SCH_SHM_VERSION);
+      return -1;
+    }
+  Cores = (const uint8_t *)Map + sizeof(Sch_ShmHeader_t);
+  Tasks = Cores + (size_t)Header->Cores * Header->CoreSize;
+
+  Entries = Header->Cores * Header->MaxTasks;
+  PrevCores = calloc(Header->Cores, sizeof(Sch_ShmCore_t));
+  PrevTasks = calloc(Entries, sizeof(Sch_ShmTask_t));
+  Rows = calloc(Header->MaxTasks, sizeof(TopRow_t));
+  if (PrevCores == NULL || PrevTasks == NULL || Rows == NULL)
+    {
+      fprintf(stderr, "out of memory\n");
+      return -1;
+    }
+  return 0;
+}
+
+/**
+ * @brief Read every entry, print the rates since the previous sample
+ * and keep this one as the next baseline.
+ *
+ * @param Seconds the time since the previous sample, 0 for none.
+ * @param Shown the tasks printed per core.
+ */
+static void Sample(const double Seconds, const uint32_t Shown)
+{
+  const int Timed = (Header->Flags & SCH_SHM_TIMED) != 0;
+  Sch_ShmCore_t Core;
+  Sch_ShmTask_t *Prev;
+  uint32_t CoreId, TaskId, Count, Index;
+  uint64_t Dispatches, Samples, BusyNs;
+
+  if (Seconds > 0.0)
+    {
+      printf("pid %" PRId64 ", tick %u us, %u core(s), %u task slots each%s\n",
+             Header->Pid, Header->TickUs, Header->Cores, Header->MaxTasks,
+             Timed ? "" : ", no run times (built without SCH_STATS)");
+    }
+  for (CoreId = 0; CoreId < Header->Cores; CoreId++)
+    {
+      // A stale entry is better than a stuck viewer
+      if (Shm_Read(&Core, Cores + (size_t)CoreId * Header->CoreSize,
+                   sizeof(Core), TOP_READ_TRIES) != 0)
+        {
+          Core = PrevCores[CoreId];
+        }
+      Count = 0;
+      BusyNs = 0;
+      for (TaskId = 0; TaskId < Header->MaxTasks; TaskId++)
+        {
+          Prev = &PrevTasks[(size_t)CoreId * Header->MaxTasks + TaskId];
+          if (Shm_Read(&Rows[Count].Now,
+                       Tasks + ((size_t)CoreId * Header->MaxTasks + TaskId) * Header->TaskSize,
+                       sizeof(Sch_ShmTask_t), TOP_READ_TRIES) != 0)
+            {
+              Rows[Count].Now = *Prev;
+            }
+          // A slot reused by another task restarts its counters
+          if (Rows[Count].Now.Releases < Prev->Releases ||
+              Rows[Count].Now.Dispatches < Prev->Dispatches)
+            {
+              *Prev = (Sch_ShmTask_t){ 0 };
+            }
+          Rows[Count].TaskId = TaskId;
+          Rows[Count].Releases = Rows[Count].Now.Releases - Prev->Releases;
+          Rows[Count].Dispatches = Rows[Count].Now.Dispatches - Prev->Dispatches;
+          Rows[Count].BusyNs = Rows[Count].Now.TotalNs - Prev->TotalNs;
+          *Prev = Rows[Count].Now;
+          if (Rows[Count].Now.Live)
+            {
+              BusyNs += Rows[Count].BusyNs;
+              Count++;
+            }
+        }
+      if (Seconds > 0.0)
+        {
+          Dispatches = Core.Dispatches - PrevCores[CoreId].Dispatches;
+          Samples = Core.LatencySamples - PrevCores[CoreId].LatencySamples;
+          printf("\ncore %u: %u tasks, %.1f ticks/s, %.1f wakeups/s, %.1f rounds/s",
+                 CoreId, Count,
+                 (double)(Core.Ticks - PrevCores[CoreId].Ticks) / Seconds,
+                 (double)(Core.Wakeups - PrevCores[CoreId].Wakeups) / Seconds,
+                 (double)(Core.Rounds - PrevCores[CoreId].Rounds) / Seconds);
+          if (Timed)
+            {
+              printf(", busy %.1f%%, %.1f dispatches/s, latency mean %.1f us max %.1f us, "
+                     "max backlog %" PRIu64 ", budget cuts %" PRIu64,
+                     100.0 * (double)BusyNs / (Seconds * 1e9),
+                     (double)Dispatches / Seconds,
+                     Samples ? (double)(Core.LatencyTotalNs -
+                                        PrevCores[CoreId].LatencyTotalNs) / Samples / 1e3 : 0.0,
+                     (double)Core.LatencyMaxNs / 1e3, Core.MaxBacklog, Core.BudgetCuts);
+            }
+          printf("\n%6s %8s %6s %10s %10s %10s %9s %9s %9s %6s\n",
+                 "ID", "PERIOD", "RUNME", "REL/S", "DISP/S", "MISSED",
+                 "OVERRUNS", "MEAN_US", "MAX_US", "CPU%");
+          qsort(Rows, Count, sizeof(TopRow_t), CompareRows);
+          for (Index = 0; Index < Count && Index < Shown; Index++)
+            {
+              Sch_ShmTask_t *Now = &Rows[Index].Now;
+
+              printf("%6u %8u %6u %10.1f %10.1f %10" PRIu64 " %9" PRIu64 " %9.1f %9.1f %6.2f\n",
+                     Rows[Index].TaskId, Now->Period, Now->RunMe,
+                     (double)Rows[Index].Releases / Seconds,
+                     (double)Rows[Index].Dispatches / Seconds,
+                     Now->Missed, Now->Overruns,
+                     Now->Dispatches ? (double)Now->TotalNs / Now->Dispatches / 1e3 : 0.0,
+                     (double)Now->MaxNs / 1e3,
+                     100.0 * (double)Rows[Index].BusyNs / (Seconds * 1e9));
+            }
+        }
+      PrevCores[CoreId] = Core;
+    }
+}
+
+/**
+ * @brief qsort order of the rows: the busiest first, then the most run.
+ */
+static int CompareRows(const void *A, const void *B)
+{
+  const TopRow_t *RowA = A, *RowB = B;
+
+  if (RowA->BusyNs != RowB->BusyNs)
+    {
+      return RowA->BusyNs < RowB->BusyNs ? 1 : -1;
+    }
+  if (RowA->Dispatches != RowB->Dispatches)
+    {
+      return RowA->Dispatches < RowB->Dispatches ? 1 : -1;
+    }
+  return RowA->TaskId < RowB->TaskId ? -1 : 1;
+}
+
+/**
+ * @brief The CLOCK_MONOTONIC time in seconds.
+ */
+static double NowSec(void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return (double)Now.tv_sec + (double)Now.tv_nsec / 1e9;
+}
@@ -0,0 +1,226 @@
+/**
+ * @file sch_trace2json.c
+ * @author Mohamed Hassanin
+ * @brief Converter of a scheduler trace dump (SCH_TRACE, see
+ *  Sch_TraceDump and POSIX/sch_trace.h) to the Chrome trace event JSON
+ *  format, which chrome://tracing and ui.perfetto.dev open.
+ *
+ *  Every instance is a thread of the timeline: its task runs and sleeps
+ *  are slices, the ticks, releases and overruns are instant events. The
+ *  times are in us from the first event of the dump.
+ *
+ *  Usage: sch_trace2json [-o out.json] trace.bin
+ * @version 0.1
+ * @date 2021-03-04
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include "../POSIX/sch_trace.h"
+
+/* The fields every event has: process, thread (the instance) and time */
+#define JSON_COMMON ",\"pid\":%" PRId64 ",\"tid\":%u,\"ts\":%.3f"
+
+/**
+ * @brief The events of one instance read from the dump.
+ *
+ */
+typedef struct
+{
+  Sch_TraceBlock_t Block;
+  Sch_TraceEvent_t *Events;
+} TraceCore_t;
+
+static int ReadDump(FILE *In, Sch_TraceHeader_t *Header, TraceCore_t **Cores);
+static void WriteJson(FILE *Out, const Sch_TraceHeader_t *Header, const TraceCore_t *Cores);
+static void WriteEvent(FILE *Out, const Sch_TraceHeader_t *Header, const uint32_t Core,
+                       const Sch_TraceEvent_t *Event, const uint64_t Origin, uint8_t *First);
+
+int main(int argc, char *argv[])
+{
+  const char *OutPath = NULL;
+  Sch_TraceHeader_t Header;
+  TraceCore_t *Cores;
+  FILE *In, *Out = stdout;
+  int Option, Status;
+
+  while ((Option = getopt(argc, argv, "o:")) != -1)
+    {
+      switch (Option)
+        {
+        case 'o': OutPath = optarg; break;
+        default:
+          fprintf(stderr, "usage: %s [-o out.json] trace.bin\n", argv[0]);
+          return EXIT_FAILURE;
+        }
+    }
+  if (optind != argc - 1)
+    {
+      fprintf(stderr, "usage: %s [-o out.json] trace.bin\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  In = fopen(argv[optind], "rb");
+  if (In == NULL)
+    {
+      perror(argv[optind]);
+      return EXIT_FAILURE;
+    }
+  Status = ReadDump(In, &Header, &Cores);
+  fclose(In);
+  if (Status != 0)
+    {
+      fprintf(stderr, "%s: not a version %u scheduler trace\n", argv[optind], SCH_TRACE_VERSION);
+      return EXIT_FAILURE;
+    }
+
+  if (OutPath != NULL && (Out = fopen(OutPath, "w")) == NULL)
+    {
+      perror(OutPath);
+      return EXIT_FAILURE;
+    }
+  WriteJson(Out, &Header, Cores);
+  if (fclose(Out) != 0)
+    {
+      perror(OutPath != NULL ? OutPath : "stdout");
+      return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Read and check the header, then the events of every instance.
+ *
+ * @return int 0 on success, -1 if the file is truncated or not a dump.
+ */
+static int ReadDump(FILE *In, Sch_TraceHeader_t *Header, TraceCore_t **Cores)
+{
+  uint32_t Core;
+
+  if (fread(Header, sizeof(*Header), 1, In) != 1 ||
+      Header->Magic != SCH_TRACE_MAGIC || Header->Version != SCH_TRACE_VERSION ||
+      Header->EventSize != sizeof(Sch_TraceEvent_t) || Header->Cores == 0)
+    {
+      return -1;
+    }
+  *Cores = calloc(Header->Cores, sizeof(TraceCore_t));
+  if (*Cores == NULL)
+    {
+      return -1;
+    }
+  for (Core = 0; Core < Header->Cores; Core++)
+    {
+      TraceCore_t *Entry = &(*Cores)[Core];
+
+      if (fread(&Entry->Block, sizeof(Entry->Block), 1, In) != 1)
+        {
+          return -1;
+        }
+      Entry->Events = malloc((size_t)Entry->Block.Count * sizeof(Sch_TraceEvent_t) + 1);
+      if (Entry->Events == NULL ||
+          fread(Entry->Events, sizeof(Sch_TraceEvent_t), Entry->Block.Count, In) !=
+          Entry->Block.Count)
+        {
+          return -1;
+        }
+    }
+  return 0;
+}
+
+/**
+ * @brief Write the whole timeline, the instances one after the other:
+ * the viewers sort the events by time themselves.
+ */
+static void WriteJson(FILE *Out, const Sch_TraceHeader_t *Header, const TraceCore_t *Cores)
+{
+  uint64_t Origin = UINT64_MAX;
+  uint32_t Core, Index;
+  uint8_t First;
+
+  for (Core = 0; Core < Header->Cores; Core++)
+    {
+      if (Cores[Core].Block.Count != 0 && Cores[Core].Events[0].Ns < Origin)
+        {
+          Origin = Cores[Core].Events[0].Ns;
+        }
+    }
+
+  fprintf(Out, "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"tick_us\":%u},\"traceEvents\":[\n",
+          Header->TickUs);
+  fprintf(Out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%" PRId64 ",\"args\":{\"name\":\"sch %" PRId64 "\"}}",
+          Header->Pid, Header->Pid);
+  for (Core = 0; Core < Header->Cores; Core++)
+    {
+      fprintf(Out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%" PRId64 ",\"tid\":%u,"
+              "\"args\":{\"name\":\"core %u (%" PRIu64 " events lost)\"}}",
+              Header->Pid, Cores[Core].Block.Core, Cores[Core].Block.Core, Cores[Core].Block.Lost);
+      First = 1;
+      for (Index = 0; Index < Cores[Core].Block.Count; Index++)
+        {
+          WriteEvent(Out, Header, Cores[Core].Block.Core, &Cores[Core].Events[Index], Origin, &First);
+        }
+    }
+  fprintf(Out, "\n]}\n");
+}
+
+/**
+ * @brief Write one event as a JSON trace event.
+ *
+ * @param First 1 until the first slice end of the instance: an end whose
+ * start was overwritten in the ring is dropped.
+ */
+static void WriteEvent(FILE *Out, const Sch_TraceHeader_t *Header, const uint32_t Core,
+                       const Sch_TraceEvent_t *Event, const uint64_t Origin, uint8_t *First)
+{
+  const double Ts = (double)(Event->Ns - Origin) / 1e3;
+
+  switch (Event->Type)
+    {
+    case SCH_TRACE_RUN_START:
+      *First = 0;
+      fprintf(Out, ",\n{\"name\":\"task %u\",\"cat\":\"run\",\"ph\":\"B\"", Event->Id);
+      fprintf(Out, JSON_COMMON, Header->Pid, Core, Ts);
+      fprintf(Out, ",\"args\":{\"owner\":%u,\"instances\":%u}}", Event->Owner, Event->Arg);
+      break;
+    case SCH_TRACE_SLEEP_ENTER:
+      *First = 0;
+      fprintf(Out, ",\n{\"name\":\"sleep\",\"cat\":\"idle\",\"ph\":\"B\"");
+      fprintf(Out, JSON_COMMON, Header->Pid, Core, Ts);
+      fprintf(Out, ",\"args\":{\"tick\":%u}}", Event->Id);
+      break;
+    case SCH_TRACE_RUN_END:
+    case SCH_TRACE_SLEEP_EXIT:
+      if (*First)
+        {
+          break;
+        }
+      fprintf(Out, ",\n{\"ph\":\"E\"");
+      fprintf(Out, JSON_COMMON, Header->Pid, Core, Ts);
+      fprintf(Out, "}");
+      break;
+    case SCH_TRACE_TICK:
+      fprintf(Out, ",\n{\"name\":\"tick\",\"cat\":\"tick\",\"ph\":\"i\",\"s\":\"t\"");
+      fprintf(Out, JSON_COMMON, Header->Pid, Core, Ts);
+      fprintf(Out, ",\"args\":{\"next\":%u,\"ticks\":%u}}", Event->Id, Event->Arg);
+      break;
+    case SCH_TRACE_RELEASE:
+      fprintf(Out, ",\n{\"name\":\"release task %u\",\"cat\":\"release\",\"ph\":\"i\",\"s\":\"t\"",
+              Event->Id);
+      fprintf(Out, JSON_COMMON, Header->Pid, Core, Ts);
+      fprintf(Out, ",\"args\":{\"runs\":%u}}", Event->Arg);
+      break;
+    case SCH_TRACE_OVERRUN:
+      fprintf(Out, ",\n{\"name\":\"overrun task %u\",\"cat\":\"overrun\",\"ph\":\"i\",\"s\":\"p\"",
+              Event->Id);
+      fprintf(Out, JSON_COMMON, Header->Pid, Core, Ts);
+      fprintf(Out, ",\"args\":{\"owner\":%u}}", Event->Owner);
+      break;
+    default:
+      // An event type of a later version
+      break;
+    }
+}